@@ -4,6 +4,19 @@
 #include <string.h>
 #include <sys/stat.h>
 
+/* OpenMP */
+#include <omp.h>
+
+/* Memory-mapped files, and yielding the processor */
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 /* SDL2 */
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
@@ -19,6 +32,66 @@
 #define XO_FONT_SIZE_FACTOR 1.2
 #define XO_WINDOW_SIZE 372
 #define XO_BOARD_SIZE 3
+#define XO_BOARD_FULL_MASK 0x1FF
+#define XO_BOARD_LINE_COUNT 8
+#define XO_BOARD_SQUARES 9
+#define XO_BOARD_SYMMETRIES 8
+#define XO_CPU_NO_MOVE (-1)
+#define XO_CPU_SCORE_INFINITY INT32_MAX
+#define XO_CPU_ASPIRATION_WINDOW 1
+#define XO_CPU_TT_DEFAULT_SIZE (1 << 16)
+#define XO_TABLE_SIZE 19683 /* 3^9 */
+#define XO_STACK_ALIGNMENT 16
+#define XO_STACK_GENERIC_DEFAULT_SIZE (8 << 20)
+#define XO_STACK_MINIMAX_SIZE (256 << 10)
+#define XO_CPU_YBWC_MIN_MOVES 3
+#define XO_CPU_DEQUE_SIZE (XO_BOARD_SQUARES * XO_BOARD_SQUARES)
+#define XO_CPU_MCTS_NULL UINT32_MAX
+#define XO_CPU_MCTS_DEFAULT_NODES (1 << 16)
+#define XO_CPU_MCTS_DEFAULT_ITERATIONS 20000
+#define XO_CPU_MCTS_EXPLORATION 1.41421356
+#define XO_CPU_MCTS_VIRTUAL_LOSS 1
+#define XO_MNK_MAX_SIZE 19
+#define XO_MNK_MAX_PLIES (XO_MNK_MAX_SIZE * XO_MNK_MAX_SIZE)
+#define XO_MNK_WORDS 6 /* (XO_MNK_MAX_SIZE + 1) * XO_MNK_MAX_SIZE bits */
+#define XO_MNK_BITS (XO_MNK_WORDS * 64)
+#define XO_TABLEBASE_MAX_CELLS 64
+#define XO_TABLEBASE_MAGIC "XOTB"
+#define XO_TABLEBASE_VERSION 1
+#define XO_TABLEBASE_PATH "xo_3x3.tb"
+#define XO_DFPN_INFINITY 0x3FFFFFFFu
+#define XO_DFPN_BUCKET_SIZE 4
+#define XO_DFPN_EPSILON 4 /* The best move may pass the second best by 1/4 */
+#define XO_DFPN_REPORT_NODES (1 << 20)
+#define XO_TSS_MAX_DEPTH 64 /* Attacker moves in a threat sequence */
+#define XO_TSS_TABLE_SIZE (1 << 16) /* Entries, a power of two */
+#define XO_MNK_SCORE_WIN 10000 /* Plus the cells left empty */
+#define XO_MNK_SCORE_EVAL_MAX 5000 /* Evaluations are clamped below wins */
+#define XO_MNK_CPU_TIME_MS 500 /* Default thinking time off the 3x3 board */
+#define XO_MNK_TSS_SHARE 10 /* Each threat search of a move takes 1/10 of
+                               its budget */
+#define XO_MNK_BENCH_POSITIONS 64
+#define XO_MNK_BENCH_NODES 200000 /* Nodes the kernel benchmark searches */
+#define XO_MNK_BENCH_WIDTH 15 /* Gomoku */
+#define XO_MNK_BENCH_HEIGHT 15
+#define XO_MNK_BENCH_K 5
+#define XO_MNK_BENCH_DEPTH 7
+#define XO_QUBIC_SIZE 4 /* Cells along each edge of the Qubic cube */
+#define XO_QUBIC_CELLS 64
+#define XO_QUBIC_LINES 76
+#define XO_QUBIC_CELL_LINES 7 /* Most lines through one cell */
+#define XO_QUBIC_SCORE_WIN 10000 /* Plus the cells left empty, within the
+                                    int16_t of the transposition table */
+#define XO_QUBIC_BENCH_DEPTH 6
+#define XO_ULTIMATE_CELLS 81
+#define XO_ULTIMATE_SCORE_WIN 10000 /* Plus the cells left empty */
+#define XO_ULTIMATE_BENCH_DEPTH 9
+#define XO_GRAVITY_SCORE_WIN 10000 /* Plus the cells left empty */
+#define XO_GRAVITY_MAX_PLIES (XO_MNK_MAX_SIZE * XO_MNK_MAX_SIZE)
+#define XO_GRAVITY_BENCH_WIDTH 7 /* Connect Four */
+#define XO_GRAVITY_BENCH_HEIGHT 6
+#define XO_GRAVITY_BENCH_K 4
+#define XO_GRAVITY_BENCH_DEPTH 10
 #define XO_BORDER 4
 
 enum xo_win_state_type
@@ -37,6 +110,15 @@ enum xo_game_state
   XO_GAME_STATE_OVER
 };
 
+/* Rules of the game played. */
+enum xo_variant_type
+{
+  XO_VARIANT_MNK,   /* K in a row on a flat board */
+  XO_VARIANT_QUBIC, /* 4 in a row in a 4x4x4 cube */
+  XO_VARIANT_ULTIMATE, /* Ultimate tic-tac-toe, on 9 3x3 boards */
+  XO_VARIANT_GRAVITY,  /* K in a row, with pieces dropped in columns */
+};
+
 struct xo_mouse
 {
   SDL_Point coordinates;
@@ -45,29 +127,76 @@ struct xo_mouse
 
 struct xo_board_data
 {
-  uint8_t squares[3][3];
+  uint16_t x;
+  uint16_t o;
+  uint16_t x_lines;
+  uint16_t o_lines;
 
-  /* To encode the status of each square in the squares array, we use the
-   * following bitwise scheme:
+  /* Each side owns a 9-bit occupancy mask. Square (col, row) maps to bit
+   * (row * XO_BOARD_SIZE + col):
    *
-   * 0b00000001 = Empty
-   * 0b00000010 = X
-   * 0b00000100 = O
-   * 0b00001000 = The square is hovered
-   * 0b00010000 = The square is clicked
-   * 0b00100000
-   * to
-   * 0b10000000 = Reserved
-   * This scheme is represented in the bit_meaning_type enum.
+   * 0 1 2
+   * 3 4 5
+   * 6 7 8
+   *
+   * A square is empty when neither mask has its bit set.
+   *
+   * The *_lines fields count the pieces each side has on each winning line,
+   * 2 bits per line in xo_board_win_masks order. They are kept up to date by
+   * xo_board_make_move and xo_board_unmake_move, so a move that completes a
+   * line is seen without rescanning the board. The whole position fits in 64
+   * bits, so the search passes and copies it by value.
    */
 };
 
+/* Bit set over the cells of an m,n,k board, see struct xo_mnk_geometry. */
+struct xo_mnk_bits
+{
+  uint64_t words[XO_MNK_WORDS];
+};
+
+/* Shape of an m,n,k game: a width x height board where k in a row wins.
+ * Cell (col, row) maps to bit (row * stride + col), with stride = width + 1:
+ * the bit after each row is padding that is never set, so shifting a bit set
+ * by 1, stride - 1, stride or stride + 1 moves every cell to its neighbour in
+ * one of the four line directions without wrapping into the next row. */
+struct xo_mnk_geometry
+{
+  uint8_t width;
+  uint8_t height;
+  uint8_t k;
+  uint8_t stride;
+  uint8_t word_count; /* Words of xo_mnk_bits in use */
+  uint8_t symmetry_count; /* 8 on a square board, 4 otherwise, see
+                             xo_mnk_symmetry_bits */
+  uint16_t cells;
+  struct xo_mnk_bits full; /* Every cell of the board */
+};
+
+struct xo_mnk_board
+{
+  struct xo_mnk_bits x;
+  struct xo_mnk_bits o;
+  uint16_t count; /* Pieces on the board */
+};
+
+struct xo_board_ui
+{
+  uint16_t hover;
+  uint16_t click;
+
+  /* UI-only square flags, using the same bit layout as xo_board_data. They
+   * are kept apart so that the positions seen by the CPU stay minimal. */
+};
+
 struct xo_board
 {
   SDL_Texture *image;
-  struct xo_board_data *data;
+  struct xo_mnk_board pieces; /* On the board of xo_game.geometry */
+  struct xo_board_ui ui;
 };
 
+/* score is from the point of view of O, see xo_game_cpu_score_final. */
 struct xo_cpu_response
 {
   int32_t score;
@@ -76,6 +205,8 @@ struct xo_cpu_response
   SDL_Point move;
 };
 
+/* Side and UI flags understood by the xo_board_bit_* functions. EMPTY, X and O
+ * are stored in xo_board_data, HOVER and CLICK in xo_board_ui. */
 enum xo_bit_meaning_type
 {
   XO_BIT_MEANING_EMPTY = 1 << 0,  /* 0b00000001 */
@@ -85,6 +216,460 @@ enum xo_bit_meaning_type
   XO_BIT_MEANING_CLICK = 1 << 4,  /* 0b00010000 */
 };
 
+/* The 8 symmetries of the square (D4 group), as applied to positions by
+ * xo_board_transform. Rotations are clockwise. */
+enum xo_board_symmetry_type
+{
+  XO_BOARD_SYMMETRY_IDENTITY,
+  XO_BOARD_SYMMETRY_ROTATE_90,
+  XO_BOARD_SYMMETRY_ROTATE_180,
+  XO_BOARD_SYMMETRY_ROTATE_270,
+  XO_BOARD_SYMMETRY_MIRROR, /* Left-right, like xo_util_surface_mirror */
+  XO_BOARD_SYMMETRY_FLIP,   /* Top-bottom, like xo_util_surface_flip */
+  XO_BOARD_SYMMETRY_TRANSPOSE,      /* Across the main diagonal */
+  XO_BOARD_SYMMETRY_ANTI_TRANSPOSE, /* Across the other diagonal */
+};
+
+enum xo_cpu_move_order_type
+{
+  XO_CPU_MOVE_ORDER_NATURAL, /* Column by column, as the board is stored */
+  XO_CPU_MOVE_ORDER_STATIC,  /* Center, then corners, then edges */
+  XO_CPU_MOVE_ORDER_DYNAMIC, /* XO_CPU_MOVE_ORDER_STATIC, with the killer
+                                moves first and squares of a class sorted by
+                                history score */
+};
+
+enum xo_cpu_bound_type
+{
+  XO_CPU_BOUND_NONE,  /* Unused table entry */
+  XO_CPU_BOUND_EXACT, /* The score is exact */
+  XO_CPU_BOUND_LOWER, /* The real score is at least the stored score */
+  XO_CPU_BOUND_UPPER, /* The real score is at most the stored score */
+};
+
+struct xo_cpu_tt_entry
+{
+  uint64_t key;
+  int32_t score;
+  uint8_t bound;
+  int16_t move; /* A cell of up to XO_MNK_BITS on the m,n,k boards */
+  uint8_t depth; /* Plies searched below the position */
+};
+
+/* A transposition table slot as stored. data packs the score, bound and move
+ * of an entry (see xo_game_cpu_tt_store) and check is key ^ data. Both words
+ * are read and written atomically but separately, so a slot torn by two
+ * threads writing at once fails the check and is simply a miss: threads share
+ * the table without any lock. */
+struct xo_cpu_tt_slot
+{
+  uint64_t check;
+  uint64_t data;
+};
+
+struct xo_cpu_tt
+{
+  struct xo_cpu_tt_slot *slots;
+  size_t mask;
+};
+
+enum xo_cpu_table_mode_type
+{
+  XO_CPU_TABLE_OFF,    /* Always search */
+  XO_CPU_TABLE_ON,     /* Answer from the generated table */
+  XO_CPU_TABLE_VERIFY, /* Search, and check the table against the search */
+  XO_CPU_TABLE_TABLEBASE, /* Answer from a tablebase file, or one built at
+                             startup */
+};
+
+enum xo_cpu_engine_type
+{
+  XO_CPU_ENGINE_SERIAL,     /* One thread */
+  XO_CPU_ENGINE_ROOT_SPLIT, /* Root moves shared out among OpenMP threads */
+  XO_CPU_ENGINE_LAZY_SMP,   /* Threads search the whole tree, sharing the
+                               transposition table */
+  XO_CPU_ENGINE_YBWC,       /* Young Brothers Wait with work stealing */
+  XO_CPU_ENGINE_MCTS,       /* Monte Carlo tree search (UCT), with the
+                               threads sharing one tree */
+  XO_CPU_ENGINE_MCTS_ROOT,  /* MCTS with a private tree per thread, merged
+                               at the root */
+};
+
+struct xo_table_entry
+{
+  int8_t score;
+  int8_t move;
+};
+
+struct xo_cpu_config
+{
+  enum xo_cpu_move_order_type move_order;
+  size_t tt_size;
+  enum xo_cpu_table_mode_type table_mode;
+  size_t memory_size;
+  enum xo_cpu_engine_type engine;
+  int threads;
+  uint32_t mcts_nodes;
+  uint32_t mcts_iterations;
+  uint32_t time_limit_ms; /* 0 for no limit */
+  uint64_t node_limit;    /* 0 for no limit */
+  SDL_bool b_pvs; /* Principal variation search and aspiration windows */
+  const char *tablebase_path; /* NULL for XO_TABLEBASE_PATH */
+};
+
+struct xo_cpu_stats
+{
+  uint64_t nodes;
+  uint64_t tt_probes;
+  uint64_t tt_hits;
+  uint64_t tt_stores;
+  uint64_t steals;     /* YBWC jobs taken from another thread */
+  uint64_t idle_ticks; /* YBWC time spent without work, in performance
+                          counter ticks */
+  uint64_t search_ticks; /* Time spent searching, in performance counter
+                            ticks */
+  uint64_t researches;   /* PVS and aspiration searches done again with a
+                            wider window */
+  uint64_t cutoffs;
+  uint64_t first_move_cutoffs; /* Cutoffs by the first move searched */
+};
+
+/* Scratch memory of one search ply, taken from minimax_stack. */
+struct xo_cpu_ply
+{
+  uint64_t hashes[XO_BOARD_SYMMETRIES];
+  uint8_t moves[XO_BOARD_SQUARES];
+};
+
+/* A YBWC split point: a node whose first move has been searched, and whose
+ * other moves are shared out as jobs. It lives on the stack of the thread
+ * searching the node, which waits until all its jobs are done. */
+struct xo_cpu_split
+{
+  struct xo_cpu_split *parent; /* Split point the node was searched under */
+  struct xo_board_data board;
+  enum xo_bit_meaning_type side;
+  uint8_t ply;
+  uint64_t hashes[XO_BOARD_SYMMETRIES];
+  int32_t alpha;
+  int32_t beta;
+  int32_t best_score;
+  int8_t best_square;
+  int pending; /* Jobs not finished yet */
+  int cutoff;  /* Set when the jobs left cannot change the result */
+};
+
+struct xo_cpu_job
+{
+  struct xo_cpu_split *split;
+  uint8_t square;
+};
+
+/* Jobs of one YBWC thread. The owner pushes and pops at the bottom, other
+ * threads steal the oldest jobs, which are the largest, from the top. */
+struct xo_cpu_deque
+{
+  omp_lock_t lock;
+  int top;
+  int bottom;
+  struct xo_cpu_job jobs[XO_CPU_DEQUE_SIZE];
+};
+
+/* State shared by the threads of a YBWC search. */
+struct xo_cpu_ybwc
+{
+  struct xo_cpu_deque *deques;
+  int thread_count;
+  int done; /* Set when the root search is over */
+};
+
+/* A node of the MCTS tree: the position after move. Nodes link to each other
+ * by index in the pool, and a free node is chained through next. visits
+ * counts the iterations going through the node, including those still
+ * running: they count as losses until their result is known (virtual
+ * loss), which steers the other threads to other branches. */
+struct xo_cpu_mcts_node
+{
+  uint32_t parent;
+  uint32_t child; /* First child */
+  uint32_t next;  /* Next sibling, or next free node */
+  uint32_t visits;
+  float reward;     /* Sum of the playout results for the side that played
+                       move: 1 for a win, 0.5 for a tie */
+  uint16_t untried; /* Moves without a child yet */
+  int8_t move;
+  int8_t result; /* xo_win_state_type of the position */
+};
+
+/* MCTS tree, kept from one CPU move to the next. The pool is allocated once
+ * from generic. Threads searching the tree together update the counters of
+ * the nodes atomically, and take lock to add nodes. */
+struct xo_cpu_mcts
+{
+  struct xo_cpu_mcts_node *nodes;
+  uint32_t capacity;
+  uint32_t used;
+  uint32_t free;
+  uint32_t root;
+  struct xo_board_data root_board;
+  enum xo_bit_meaning_type root_side;
+  uint64_t rng;
+  omp_lock_t lock;
+};
+
+/* Per-move limits of a search, shared by its threads. */
+struct xo_cpu_budget
+{
+  Uint64 deadline; /* Performance counter value, or 0 for no deadline */
+  int aborted;     /* Set once a limit is reached */
+};
+
+struct xo_cpu
+{
+  struct xo_cpu_config config;
+  struct xo_cpu_stats stats;
+  struct xo_cpu_tt tt;
+  struct xo_cpu_ply *plies;
+  uint8_t perturbation; /* Rotates the move order of Lazy SMP helpers */
+  int *stop; /* Set by another thread to abandon the search, or NULL */
+  struct xo_cpu_ybwc *ybwc;   /* NULL outside of the YBWC engine */
+  struct xo_cpu_split *split; /* Split point of the job being searched */
+  int id;                     /* Thread number in a parallel search */
+  struct xo_cpu_mcts mcts;
+  struct xo_cpu_budget *budget; /* NULL when the search has no limit */
+  uint64_t node_limit; /* Nodes this thread may search, or 0 for no limit */
+  uint8_t max_ply;     /* Search horizon of the current iteration */
+  /* Move ordering heuristics, see XO_CPU_MOVE_ORDER_DYNAMIC: the last two
+   * moves that caused a cutoff at each ply, and a score per side and square
+   * that grows with every cutoff the square causes. */
+  int8_t killers[XO_BOARD_SQUARES + 1][2];
+  uint32_t history[2][XO_BOARD_SQUARES];
+  struct xo_tablebase *tablebase; /* NULL unless table_mode is
+                                     XO_CPU_TABLE_TABLEBASE */
+};
+
+/* A game searched by xo_game_cpu_variant_search: the m,n,k boards other
+ * than 3x3, and the other variants. */
+struct xo_cpu_variant
+{
+  const char *name;
+  int32_t score_win; /* Scores of won positions are at least this */
+  /* Searches root to a fixed depth on the thread of cpu, starting its move
+   * order from a cell that depends on cpu->perturbation */
+  int32_t (*search) (struct xo_cpu *cpu, const void *root,
+                     enum xo_bit_meaning_type side, uint8_t depth,
+                     int16_t *move);
+};
+
+/* A Qubic position. Cell z * 16 + y * 4 + x, at column x and row y of
+ * layer z, is the bit of the same number in the set of each side, so that a
+ * side fits in one word. */
+struct xo_qubic_board
+{
+  uint64_t x;
+  uint64_t o;
+  uint8_t count; /* Pieces on the board */
+};
+
+/* One thread of a Qubic search. */
+struct xo_qubic_search
+{
+  struct xo_cpu *cpu; /* Transposition table, budget and statistics */
+  struct xo_qubic_board board;
+  int8_t killers[XO_QUBIC_CELLS + 1]; /* Last move that caused a cutoff at
+                                         each ply */
+};
+
+/* An ultimate tic-tac-toe position: 9 local 3x3 boards, and the global 3x3
+ * board of the local boards each side won. Move board * 9 + square plays on
+ * that square of that local board, and sends the other side to the local
+ * board of the same number. */
+struct xo_ultimate_board
+{
+  struct xo_board_data locals[XO_BOARD_SQUARES];
+  struct xo_board_data global; /* Local boards won by each side */
+  uint16_t closed; /* Local boards won or full, where no one can play */
+  int8_t next; /* Local board the side to move must play in, or
+                  XO_CPU_NO_MOVE when it may pick any open one */
+  uint8_t count; /* Pieces on the board */
+};
+
+/* One thread of an ultimate tic-tac-toe search. */
+struct xo_ultimate_search
+{
+  struct xo_cpu *cpu; /* Transposition table, budget and statistics */
+  int8_t killers[XO_ULTIMATE_CELLS + 1]; /* Last move that caused a cutoff
+                                            at each ply */
+};
+
+/* A position of the gravity variant: the pieces of an m,n,k board, and the
+ * cell a piece dropped in each column lands on, which is one bit per column
+ * that is not full. The moves are the bits of heights. */
+struct xo_gravity_board
+{
+  const struct xo_mnk_geometry *geometry;
+  struct xo_mnk_board pieces;
+  struct xo_mnk_bits heights;
+};
+
+/* One thread of a gravity search. */
+struct xo_gravity_search
+{
+  struct xo_cpu *cpu; /* Transposition table, budget and statistics */
+  struct xo_gravity_board board;
+  int8_t killers[XO_GRAVITY_MAX_PLIES + 1]; /* Last column that caused a
+                                               cutoff at each ply */
+};
+
+/* Value of a position for the side to move, as stored in a tablebase. */
+enum xo_tablebase_value_type
+{
+  XO_TABLEBASE_DRAW,
+  XO_TABLEBASE_WIN,
+  XO_TABLEBASE_LOSS,
+  XO_TABLEBASE_UNKNOWN, /* Not held by the tablebase */
+};
+
+/* The positions of a tablebase with the same number of pieces, in
+ * xo_tablebase_rank order. Their values are two bit planes: a position is a
+ * draw when it is in neither. */
+struct xo_tablebase_layer
+{
+  uint64_t size; /* Positions */
+  const uint64_t *wins;
+  const uint64_t *losses;
+};
+
+struct xo_tablebase
+{
+  struct xo_mnk_geometry geometry;
+  const struct xo_mnk_kernel *kernel; /* Win check of the board */
+  uint8_t min_pieces; /* Layers with fewer pieces are not held */
+  struct xo_tablebase_layer layers[XO_TABLEBASE_MAX_CELLS + 1];
+  void *mapping; /* File the layers point into, or NULL when they were built
+                    in memory */
+  size_t mapping_size;
+};
+
+/* Positions a tablebase file holds values for. */
+enum xo_tablebase_symmetry_type
+{
+  XO_TABLEBASE_SYMMETRY_NONE, /* Every position, each under its own rank */
+};
+
+/* Start of a tablebase file. The layers follow, from min_pieces up, each as
+ * its wins bit plane then its losses bit plane, in native 64-bit words: the
+ * file is used as it is mapped, without any decoding. */
+struct xo_tablebase_header
+{
+  char magic[4]; /* XO_TABLEBASE_MAGIC */
+  uint16_t version;
+  uint8_t width;
+  uint8_t height;
+  uint8_t k;
+  uint8_t min_pieces;
+  uint8_t symmetry; /* xo_tablebase_symmetry_type */
+  uint8_t reserved;
+  uint32_t byte_order; /* 0x01020304 as written by the machine that built it */
+  uint64_t offsets[XO_TABLEBASE_MAX_CELLS + 1]; /* Offset in bytes of each
+                                                   layer from the start of the
+                                                   file, 0 if not held */
+};
+
+/* Proof and disproof numbers of a position, as stored by the df-pn solver.
+ * work counts the nodes searched to get them, and is 0 for an empty entry. */
+struct xo_dfpn_entry
+{
+  uint64_t key;
+  uint32_t proof;
+  uint32_t disproof;
+  uint64_t work;
+};
+
+/* A move of a df-pn node, with the numbers of the position it leads to. */
+struct xo_dfpn_child
+{
+  uint64_t key; /* Smallest hash of the position under the symmetries */
+  uint32_t proof;
+  uint32_t disproof;
+  uint16_t bit;
+  SDL_bool b_terminal; /* The numbers are final, not read from the table */
+};
+
+/* Depth-first proof-number search of an m,n,k game. It proves or disproves
+ * that attacker wins, in a table of a fixed number of entries: when a bucket
+ * is full, the unsolved entry that took the least work to compute is
+ * replaced. */
+struct xo_dfpn
+{
+  struct xo_mnk_geometry geometry;
+  const struct xo_mnk_kernel *kernel; /* Win check of the board */
+  struct xo_mnk_board board;
+  enum xo_bit_meaning_type attacker;
+  struct xo_dfpn_entry *table;
+  size_t bucket_mask;
+  size_t used; /* Entries filled */
+  uint64_t replacements;
+  struct xo_dfpn_child *children; /* geometry.cells moves per ply */
+  uint64_t nodes;
+  uint32_t root_proof;
+  uint32_t root_disproof;
+  Uint64 start;
+};
+
+/* Position of a threat-space search where the attacker, to move, has no
+ * threat win within depth threats. */
+struct xo_tss_entry
+{
+  uint64_t key;
+  uint8_t depth; /* XO_TSS_MAX_DEPTH + 1 if it has none at any depth */
+};
+
+/* One thread of the CPU search on boards other than 3x3, see
+ * xo_mnk_search_node. */
+struct xo_mnk_search
+{
+  struct xo_cpu *cpu; /* Transposition table, budget and statistics */
+  const struct xo_mnk_geometry *geometry;
+  const struct xo_mnk_kernel *kernel; /* Kernel of the board */
+  const struct xo_tablebase *tablebase; /* Of the board, or NULL */
+  struct xo_mnk_board board;
+  uint16_t killers[XO_MNK_MAX_PLIES + 1]; /* Last move that caused a cutoff
+                                             at each ply */
+};
+
+/* Search and win-check functions of the m,n,k boards of one size, see
+ * XO_MNK_KERNEL. The generic kernel has a width of 0. */
+struct xo_mnk_kernel
+{
+  const char *name;
+  uint8_t width;
+  uint8_t height;
+  uint8_t k;
+  SDL_bool (*has_line) (const struct xo_mnk_geometry *geometry,
+                        const struct xo_mnk_bits *pieces);
+  int32_t (*negamax) (struct xo_mnk_search *search,
+                      enum xo_bit_meaning_type side, uint8_t depth,
+                      int32_t alpha, int32_t beta, uint16_t ply,
+                      uint64_t hash, uint16_t *move);
+};
+
+/* State of a threat-space search, which tries to win by threats alone. */
+struct xo_tss
+{
+  struct xo_mnk_geometry geometry;
+  struct xo_mnk_board board;
+  uint64_t key; /* Zobrist hash of board */
+  struct xo_tss_entry *table; /* XO_TSS_TABLE_SIZE entries */
+  enum xo_bit_meaning_type attacker; /* Side to move at the root */
+  enum xo_bit_meaning_type defender;
+  uint64_t nodes;
+  uint64_t node_limit; /* 0 for no limit */
+  Uint64 deadline;     /* Performance counter value, or 0 for no deadline */
+  SDL_bool b_aborted;  /* The limits were reached */
+  SDL_bool b_cut;      /* Some line was cut short by the depth limit */
+};
+
 struct xo_game
 {
   enum xo_game_state game_state;
@@ -92,7 +677,13 @@ struct xo_game
   SDL_Texture *Os;
   SDL_Texture *Xs;
   struct xo_mouse mouse;
+  enum xo_variant_type variant;
+  struct xo_mnk_geometry geometry; /* Shape of the board played on, or of
+                                      the layers of the Qubic cube side by
+                                      side */
   struct xo_board *board;
+  SDL_Point last_move; /* Square of the last move, when there was one */
+  struct xo_cpu cpu;
 };
 
 struct xo_app
@@ -107,6 +698,23 @@ struct xo_app
   Mix_Music **musics;
   int music_max;
   struct xo_game *game;
+  uint8_t board_width; /* Board played on */
+  uint8_t board_height;
+  uint8_t board_k;
+  SDL_bool b_bench;
+  uint8_t solve_width; /* Board to solve headless with df-pn, 0 for none */
+  uint8_t solve_height;
+  uint8_t solve_k;
+  uint8_t tablebase_width; /* Board to build a tablebase of headless, 0 for
+                              none */
+  uint8_t tablebase_height;
+  uint8_t tablebase_k;
+  uint8_t tablebase_pieces;
+  uint8_t threats_width; /* Board to search for a threat win headless, 0 for
+                            none */
+  uint8_t threats_height;
+  uint8_t threats_k;
+  const char *threats_position; /* Moves played before the search */
 };
 
 struct xo_stack
@@ -122,11 +730,44 @@ struct xo_stack
 #define XO_DEBUG_LOG_BASE 1
 #define XO_DEBUG_LOG_ALL 2
 
+#ifndef XO_DEBUG_LOG
 #define XO_DEBUG_LOG XO_DEBUG_LOG_ALL
-
+#endif
+
+/* Debug messages produced at run time, at most XO_DEBUG_LOG. --bench turns
+ * them off so that its timings do not include logging. */
+static int32_t xo_debug_log = XO_DEBUG_LOG;
+
+/* Size-specialized m,n,k kernels, see XO_MNK_KERNEL. 0 leaves only the
+ * generic one. */
+#ifndef XO_MNK_KERNELS
+#define XO_MNK_KERNELS 1
+#endif
+
+/* Functions the m,n,k kernels are made of. They are always inlined, so that
+ * the constants of each kernel reach every loop. */
+#if defined(__GNUC__)
+#define XO_INLINE static inline __attribute__ ((always_inline))
+#elif defined(_MSC_VER)
+#define XO_INLINE static __forceinline
+#else
+#define XO_INLINE static inline
+#endif
+
+/* Memory arenas, created once by xo_init_memory. Nothing in the search or in
+ * the frame loop calls malloc or free: long-lived engine tables come from
+ * generic, and per-search scratch comes from minimax_stack, which is rewound
+ * after every CPU move. Their sizes are the memory ceiling of the engine. */
 struct xo_stack *generic = { 0 };
 struct xo_stack *minimax_stack = { 0 };
 
+/* Perfect-play table of the 3x3 board, indexed by xo_board_index. It is
+ * generated at build time by the xo_gen_table target, which is this same
+ * file built with XO_GEN_TABLE defined. */
+#ifndef XO_GEN_TABLE
+#include "xo_table.h"
+#endif
+
 /// LOGGING
 
 /**
@@ -143,7 +784,7 @@ xo_log_debug (int32_t db_order, SDL_bool b_is_warn, const char *format, ...)
 {
   va_list args;
   va_start (args, format);
-  if (XO_DEBUG_LOG >= db_order)
+  if (XO_DEBUG_LOG >= db_order && xo_debug_log >= db_order)
     {
       SDL_LogMessageV (SDL_LOG_CATEGORY_APPLICATION,
                        b_is_warn ? SDL_LOG_PRIORITY_WARN
@@ -175,8 +816,107 @@ xo_log_error (SDL_bool b_is_critical, const char *format, ...)
   va_end (args);
 }
 
+/// MEMORY
+
+/*
+ * xo_stack is a bump allocator over one block reserved up front. Allocations
+ * move the offset forward; a mark taken with xo_stack_mark releases, with
+ * xo_stack_rewind, everything allocated after it at once.
+ */
+
+/**
+ * Reserves the memory of a stack.
+ * @param size Capacity in bytes, which allocations can never exceed
+ * @return The stack, or NULL when the memory is not available
+ */
+static struct xo_stack *
+xo_stack_create (size_t size)
+{
+  struct xo_stack *stack
+      = (struct xo_stack *)calloc (1, sizeof (struct xo_stack));
+  if (stack == NULL)
+    {
+      return NULL;
+    }
+
+  stack->bits = malloc (size);
+  if (stack->bits == NULL)
+    {
+      free (stack);
+      return NULL;
+    }
+  stack->size = size;
+  stack->offset = 0;
+  return stack;
+}
+
+/**
+ * Allocates zeroed memory from a stack, like calloc would.
+ * @param stack
+ * @param size
+ * @return The memory, or NULL when the stack is exhausted
+ */
+static void *
+xo_stack_alloc (struct xo_stack *stack, size_t size)
+{
+  size_t start = (stack->offset + XO_STACK_ALIGNMENT - 1)
+                 & ~(size_t)(XO_STACK_ALIGNMENT - 1);
+  if (start > stack->size || size > stack->size - start)
+    {
+      xo_log_error (SDL_FALSE,
+                    "Stack exhausted: %zu bytes requested, %zu of %zu "
+                    "used\n",
+                    size, stack->offset, stack->size);
+      return NULL;
+    }
+
+  void *memory = (uint8_t *)stack->bits + start;
+  stack->offset = start + size;
+  memset (memory, 0, size);
+  return memory;
+}
+
+/**
+ * Remembers the current top of a stack.
+ * @param stack
+ * @return Mark to give back to xo_stack_rewind
+ */
+static size_t
+xo_stack_mark (struct xo_stack *stack)
+{
+  return stack->offset;
+}
+
+/**
+ * Releases everything allocated since a mark was taken.
+ * @param stack
+ * @param mark
+ */
+static void
+xo_stack_rewind (struct xo_stack *stack, size_t mark)
+{
+  stack->offset = mark;
+}
+
+/**
+ * Releases the memory of a stack.
+ * @param stack
+ */
+static void
+xo_stack_destroy (struct xo_stack *stack)
+{
+  if (stack != NULL)
+    {
+      free (stack->bits);
+      free (stack);
+    }
+}
+
 /// UTILITIES
 
+#ifndef XO_GEN_TABLE
+/* The image functions, which the generator has no use for */
+
 /**
  * Gets a pixel RGBA value from a specified surface.
  * @param surface
@@ -362,7 +1102,74 @@ xo_util_surface_flip (SDL_Surface *surface)
 
   return mirrored_surface;
 }
+#endif
+
+/**
+ * Gives the rest of the time slice of the thread to the other threads, for
+ * the threads of a parallel search that have nothing to do.
+ */
+static void
+xo_util_yield (void)
+{
+#ifdef _WIN32
+  SwitchToThread ();
+#else
+  sched_yield ();
+#endif
+}
+
+/**
+ * Produces the next value of a splitmix64 sequence. Used to seed tables of
+ * random keys reproducibly.
+ * @param state Generator state, advanced on each call
+ * @return
+ */
+static uint64_t
+xo_util_splitmix64 (uint64_t *state)
+{
+  uint64_t z = (*state += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+/**
+ * Counts the set bits of a mask.
+ * @param mask
+ * @return
+ */
+static uint8_t
+xo_util_bit_count (uint16_t mask)
+{
+  uint8_t count = 0;
+  for (; mask != 0; mask &= (uint16_t)(mask - 1))
+    {
+      count++;
+    }
+  return count;
+}
+
+/**
+ * Picks one of the set bits of a mask at random.
+ * @param mask Must not be 0
+ * @param state splitmix64 generator state
+ * @return Index of the bit
+ */
+static uint8_t
+xo_util_random_bit (uint16_t mask, uint64_t *state)
+{
+  uint8_t skip
+      = (uint8_t)(xo_util_splitmix64 (state) % xo_util_bit_count (mask));
+  for (uint8_t bit = 0;; bit++)
+    {
+      if ((mask & (1u << bit)) != 0 && skip-- == 0)
+        {
+          return bit;
+        }
+    }
+}
 
+#ifndef XO_GEN_TABLE
 /**
  * Conversion function to stringify the win_state enums.
  * @param type
@@ -383,6 +1190,7 @@ xo_util_win_state_type_to_string (enum xo_win_state_type type)
       return "None";
     }
 }
+#endif
 /**
  * Conversion function to stringify the bit_meaning enums.
  * @param type
@@ -406,82 +1214,412 @@ xo_util_bit_meaning_type_to_string (enum xo_bit_meaning_type type)
     }
 }
 
+#ifndef XO_GEN_TABLE
+/**
+ * Gives the size of the window, which keeps the proportions of the board: its
+ * longer side is XO_WINDOW_SIZE.
+ * @param geometry
+ * @return
+ */
+static SDL_Point
+xo_util_window_size (const struct xo_mnk_geometry *geometry)
+{
+  int longest = SDL_max (geometry->width, geometry->height);
+  return (SDL_Point){ XO_WINDOW_SIZE * geometry->width / longest,
+                      XO_WINDOW_SIZE * geometry->height / longest };
+}
+
 /**
- * Plays the move for the player.
+ * Finds the square under the mouse.
  * @param app
  * @param mouse_x
  * @param mouse_y
- * @return Whether the player move was successful. The move can fail if the
- * square clicked already contains something.
+ * @return The column and row of the square
  */
 static SDL_Point
 xo_util_mouse_to_square (struct xo_app *app, int mouse_x, int mouse_y)
 {
-
-  int col = -1;
-  int row = -1;
-
-  if (mouse_x < XO_WINDOW_SIZE / 3)
-    {
-      // Player clicked in the left third of the window
-      col = 0;
-    }
-  else if (mouse_x < XO_WINDOW_SIZE * 2 / 3)
-    {
-      // Player clicked in the middle third of the window
-      col = 1;
-    }
-  else
-    {
-      // Player clicked in the right third of the window
-      col = 2;
-    }
-
-  if (mouse_y < XO_WINDOW_SIZE / 3)
-    {
-      // Player clicked in the top third of the window
-      row = 0;
-    }
-  else if (mouse_y < XO_WINDOW_SIZE * 2 / 3)
-    {
-      // Player clicked in the middle third of the window
-      row = 1;
-    }
-  else
-    {
-      // Player clicked in the bottom third of the window
-      row = 2;
-    }
+  const struct xo_mnk_geometry *geometry = &app->game->geometry;
+  SDL_Point window = xo_util_window_size (geometry);
+
+  /* The window is cut in width columns and height rows of the same size */
+  int col = SDL_max (
+      0, SDL_min (mouse_x * geometry->width / window.x, geometry->width - 1));
+  int row = SDL_max (0, SDL_min (mouse_y * geometry->height / window.y,
+                                 geometry->height - 1));
   xo_log_debug (1, SDL_FALSE, "Tile clicked: %d, %d.", col, row);
 
   return (SDL_Point){ col, row };
 }
+#endif
 
 /// INITIALIZATION CODE
 
 /**
- * Constructs the border part of the board surface using smaller squares. This
- * function works, but was written long ago. The work is done by CPU blitting.
- * @param surfaces Images
- * @param board Final board surface where the border is blitted to
- * @param col
- * @param row
- * @return
+ * Sets every CPU option to its default value.
+ * @param config
+ */
+static void
+xo_init_default_cpu_config (struct xo_cpu_config *config)
+{
+  config->move_order = XO_CPU_MOVE_ORDER_DYNAMIC;
+  config->tt_size = XO_CPU_TT_DEFAULT_SIZE;
+  config->table_mode = XO_CPU_TABLE_ON;
+  config->memory_size = XO_STACK_GENERIC_DEFAULT_SIZE;
+  config->engine = XO_CPU_ENGINE_SERIAL;
+  config->threads = omp_get_max_threads ();
+  config->mcts_nodes = XO_CPU_MCTS_DEFAULT_NODES;
+  config->mcts_iterations = XO_CPU_MCTS_DEFAULT_ITERATIONS;
+  config->time_limit_ms = 0;
+  config->node_limit = 0;
+  config->b_pvs = SDL_TRUE;
+  config->tablebase_path = NULL;
+}
+
+/**
+ * Creates the generic and minimax_stack memory arenas.
+ * @param config The generic arena gets config->memory_size bytes
+ * @return 0 for success
  */
 static int32_t
-xo_init_make_border (SDL_Surface **surfaces, SDL_Surface *board, int col,
-                     int row)
+xo_init_memory (struct xo_cpu_config *config)
 {
-  int32_t result = 0;
-  switch (col)
+  generic = xo_stack_create (config->memory_size);
+  minimax_stack = xo_stack_create (XO_STACK_MINIMAX_SIZE);
+  if (generic == NULL || minimax_stack == NULL)
     {
-    case 0:
-      switch (row)
-        {
-        case 0:
-          {
-            // square 0,0
-            SDL_Rect border_dest1
+      xo_log_error (SDL_TRUE, "Failed to reserve %zu bytes of memory\n",
+                    config->memory_size + XO_STACK_MINIMAX_SIZE);
+      return 1;
+    }
+
+  xo_log_debug (1, SDL_FALSE, "Memory reserved: %zu KB engine, %zu KB search",
+                config->memory_size / 1024,
+                (size_t)XO_STACK_MINIMAX_SIZE / 1024);
+  return 0;
+}
+
+
+#ifndef XO_GEN_TABLE
+/**
+ * Matches a command line argument of the form name=value.
+ * @param arg Argument as given on the command line
+ * @param name Option name, including the leading dashes
+ * @param value Receives the text after the '=' sign
+ * @return SDL_TRUE if the argument is the named option
+ */
+static SDL_bool
+xo_init_arg_value (const char *arg, const char *name, const char **value)
+{
+  size_t length = strlen (name);
+  if (strncmp (arg, name, length) != 0 || arg[length] != '=')
+    {
+      return SDL_FALSE;
+    }
+  *value = arg + length + 1;
+  return SDL_TRUE;
+}
+
+/**
+ * Reads an m,n,k board given on the command line as WxH:K.
+ * @param value Text of the option
+ * @param width
+ * @param height
+ * @param k
+ * @return SDL_TRUE if value is a board of 1 to XO_MNK_MAX_SIZE squares a
+ * side, with a K from 1 to the longer side. 0 is never accepted, as the
+ * options keep it for "not given".
+ */
+static SDL_bool
+xo_init_arg_board (const char *value, uint8_t *width, uint8_t *height,
+                   uint8_t *k)
+{
+  unsigned int values[3] = { 0 };
+  if (sscanf (value, "%ux%u:%u", &values[0], &values[1], &values[2]) != 3
+      || values[0] < 1 || values[0] > XO_MNK_MAX_SIZE || values[1] < 1
+      || values[1] > XO_MNK_MAX_SIZE || values[2] < 1
+      || values[2] > SDL_max (values[0], values[1]))
+    {
+      xo_log_error (SDL_FALSE, "Invalid board: %s\n", value);
+      return SDL_FALSE;
+    }
+  *width = (uint8_t)values[0];
+  *height = (uint8_t)values[1];
+  *k = (uint8_t)values[2];
+  return SDL_TRUE;
+}
+
+/**
+ * Reads the command line options. Options not given keep their default
+ * value:
+ * --move-order=natural|static|dynamic Order in which the CPU search tries
+ * squares
+ * --tt-size=N Transposition table entries (rounded down to a power of two,
+ * 0 disables the table)
+ * --cpu-table=on|off|verify|tablebase Answer CPU moves from the generated
+ * table, search instead, search and check the table against the search, or
+ * answer from the tablebase file of the board, which the search probes off
+ * 3x3
+ * --memory=BYTES Size of the engine memory arena, which holds the
+ * transposition table
+ * --cpu-engine=serial|root|lazy|ybwc|mcts|mcts-root Search on one thread,
+ * share the root moves out among threads, run Lazy SMP threads, run Young
+ * Brothers Wait with work stealing, or run Monte Carlo tree search on one
+ * shared tree or on a tree per thread
+ * --threads=N Number of search threads
+ * --mcts-nodes=N Size of the MCTS node pool
+ * --mcts-iterations=N MCTS playouts per CPU move
+ * --time-limit=MS Time the CPU may think per move, 0 for no limit (or
+ * XO_MNK_CPU_TIME_MS on boards other than 3x3)
+ * --node-limit=N Nodes (MCTS playouts) the CPU may search per move, 0 for no
+ * limit
+ * --pvs=on|off Principal variation search and aspiration windows, or plain
+ * alpha-beta
+ * --bench Print a comparison of the search engines and of the m,n,k kernels
+ * and quit, without opening a window
+ * --solve=WxH:K Solve the WxH board with K in a row by proof-number search
+ * and quit, without opening a window
+ * --tablebase=WxH:K Build the tablebase of the WxH board with K in a row and
+ * quit, without opening a window. It takes 2 bits per position of --memory,
+ * such as 2.4 MiB for the whole 4x4 board, and 17.4 MiB for 5x5:4 from 24
+ * pieces
+ * --tablebase-pieces=N Smallest number of pieces of the positions the
+ * tablebase holds
+ * --tablebase-file=PATH Tablebase file the CPU maps, or that --tablebase
+ * writes
+ * --threats=WxH:K Search a position of the WxH board with K in a row for a
+ * win by threats of the side to move and quit, without opening a window. The
+ * search stops at --time-limit and --node-limit
+ * --position=MOVES Moves played before --threats searches, from X on, such as
+ * h8,h9,i8
+ * --board=WxH:K Play on a WxH board where K in a row wins, instead of 3x3
+ * --variant=mnk|qubic|ultimate|gravity Play K in a row on the --board, 4 in
+ * a row in a 4x4x4 cube, ultimate tic-tac-toe, or K in a row on the --board
+ * with the pieces dropped to the bottom of their column
+ * @param app
+ * @param argc
+ * @param argv
+ * @return 0 for success
+ */
+static int32_t
+xo_init_parse_args (struct xo_app *app, int argc, char *argv[])
+{
+  struct xo_cpu_config *config = &app->game->cpu.config;
+
+  xo_init_default_cpu_config (config);
+  app->board_width = XO_BOARD_SIZE;
+  app->board_height = XO_BOARD_SIZE;
+  app->board_k = XO_BOARD_SIZE;
+
+  for (int i = 1; i < argc; i++)
+    {
+      const char *value = NULL;
+      if (strcmp (argv[i], "--move-order=natural") == 0)
+        {
+          config->move_order = XO_CPU_MOVE_ORDER_NATURAL;
+        }
+      else if (strcmp (argv[i], "--move-order=static") == 0)
+        {
+          config->move_order = XO_CPU_MOVE_ORDER_STATIC;
+        }
+      else if (strcmp (argv[i], "--move-order=dynamic") == 0)
+        {
+          config->move_order = XO_CPU_MOVE_ORDER_DYNAMIC;
+        }
+      else if (xo_init_arg_value (argv[i], "--tt-size", &value))
+        {
+          config->tt_size = (size_t)strtoull (value, NULL, 10);
+        }
+      else if (xo_init_arg_value (argv[i], "--memory", &value))
+        {
+          config->memory_size = (size_t)strtoull (value, NULL, 10);
+        }
+      else if (strcmp (argv[i], "--cpu-engine=serial") == 0)
+        {
+          config->engine = XO_CPU_ENGINE_SERIAL;
+        }
+      else if (strcmp (argv[i], "--cpu-engine=root") == 0)
+        {
+          config->engine = XO_CPU_ENGINE_ROOT_SPLIT;
+        }
+      else if (strcmp (argv[i], "--cpu-engine=lazy") == 0)
+        {
+          config->engine = XO_CPU_ENGINE_LAZY_SMP;
+        }
+      else if (strcmp (argv[i], "--cpu-engine=ybwc") == 0)
+        {
+          config->engine = XO_CPU_ENGINE_YBWC;
+        }
+      else if (strcmp (argv[i], "--cpu-engine=mcts") == 0)
+        {
+          config->engine = XO_CPU_ENGINE_MCTS;
+        }
+      else if (strcmp (argv[i], "--cpu-engine=mcts-root") == 0)
+        {
+          config->engine = XO_CPU_ENGINE_MCTS_ROOT;
+        }
+      else if (xo_init_arg_value (argv[i], "--mcts-nodes", &value))
+        {
+          config->mcts_nodes = (uint32_t)SDL_max (1, atoi (value));
+        }
+      else if (xo_init_arg_value (argv[i], "--mcts-iterations", &value))
+        {
+          config->mcts_iterations = (uint32_t)SDL_max (1, atoi (value));
+        }
+      else if (xo_init_arg_value (argv[i], "--time-limit", &value))
+        {
+          config->time_limit_ms = (uint32_t)strtoul (value, NULL, 10);
+        }
+      else if (xo_init_arg_value (argv[i], "--node-limit", &value))
+        {
+          config->node_limit = (uint64_t)strtoull (value, NULL, 10);
+        }
+      else if (strcmp (argv[i], "--pvs=on") == 0)
+        {
+          config->b_pvs = SDL_TRUE;
+        }
+      else if (strcmp (argv[i], "--pvs=off") == 0)
+        {
+          config->b_pvs = SDL_FALSE;
+        }
+      else if (strcmp (argv[i], "--bench") == 0)
+        {
+          app->b_bench = SDL_TRUE;
+        }
+      else if (xo_init_arg_value (argv[i], "--solve", &value))
+        {
+          if (!xo_init_arg_board (value, &app->solve_width,
+                                  &app->solve_height, &app->solve_k))
+            {
+              return 1;
+            }
+        }
+      else if (xo_init_arg_value (argv[i], "--tablebase", &value))
+        {
+          if (!xo_init_arg_board (value, &app->tablebase_width,
+                                  &app->tablebase_height, &app->tablebase_k))
+            {
+              return 1;
+            }
+        }
+      else if (xo_init_arg_value (argv[i], "--tablebase-file", &value))
+        {
+          config->tablebase_path = value;
+        }
+      else if (strcmp (argv[i], "--variant=mnk") == 0)
+        {
+          app->game->variant = XO_VARIANT_MNK;
+        }
+      else if (strcmp (argv[i], "--variant=qubic") == 0)
+        {
+          app->game->variant = XO_VARIANT_QUBIC;
+        }
+      else if (strcmp (argv[i], "--variant=ultimate") == 0)
+        {
+          app->game->variant = XO_VARIANT_ULTIMATE;
+        }
+      else if (strcmp (argv[i], "--variant=gravity") == 0)
+        {
+          app->game->variant = XO_VARIANT_GRAVITY;
+        }
+      else if (xo_init_arg_value (argv[i], "--board", &value))
+        {
+          if (!xo_init_arg_board (value, &app->board_width,
+                                  &app->board_height, &app->board_k))
+            {
+              return 1;
+            }
+        }
+      else if (xo_init_arg_value (argv[i], "--threats", &value))
+        {
+          if (!xo_init_arg_board (value, &app->threats_width,
+                                  &app->threats_height, &app->threats_k))
+            {
+              return 1;
+            }
+        }
+      else if (xo_init_arg_value (argv[i], "--position", &value))
+        {
+          app->threats_position = value;
+        }
+      else if (xo_init_arg_value (argv[i], "--tablebase-pieces", &value))
+        {
+          app->tablebase_pieces
+              = (uint8_t)SDL_min (strtoul (value, NULL, 10),
+                                  XO_TABLEBASE_MAX_CELLS);
+        }
+      else if (xo_init_arg_value (argv[i], "--threads", &value))
+        {
+          config->threads = SDL_max (1, atoi (value));
+        }
+      else if (strcmp (argv[i], "--cpu-table=on") == 0)
+        {
+          config->table_mode = XO_CPU_TABLE_ON;
+        }
+      else if (strcmp (argv[i], "--cpu-table=off") == 0)
+        {
+          config->table_mode = XO_CPU_TABLE_OFF;
+        }
+      else if (strcmp (argv[i], "--cpu-table=verify") == 0)
+        {
+          config->table_mode = XO_CPU_TABLE_VERIFY;
+        }
+      else if (strcmp (argv[i], "--cpu-table=tablebase") == 0)
+        {
+          config->table_mode = XO_CPU_TABLE_TABLEBASE;
+        }
+      else
+        {
+          xo_log_error (SDL_FALSE, "Unknown option ignored: %s\n", argv[i]);
+        }
+    }
+
+  /* The layers of the cube are shown side by side, two per row */
+  if (app->game->variant == XO_VARIANT_QUBIC)
+    {
+      app->board_width = 2 * XO_QUBIC_SIZE;
+      app->board_height = 2 * XO_QUBIC_SIZE;
+      app->board_k = XO_QUBIC_SIZE;
+    }
+  /* The local boards of ultimate tic-tac-toe make a 9x9 board */
+  if (app->game->variant == XO_VARIANT_ULTIMATE)
+    {
+      app->board_width = XO_BOARD_SQUARES;
+      app->board_height = XO_BOARD_SQUARES;
+      app->board_k = XO_BOARD_SIZE;
+    }
+
+  return 0;
+}
+
+/**
+ * Constructs the border part of the board surface using smaller squares. This
+ * function works, but was written long ago. The work is done by CPU blitting.
+ * @param surfaces Images
+ * @param board Final board surface where the border is blitted to
+ * @param col
+ * @param row
+ * @param geometry Shape of the board
+ * @return
+ */
+static int32_t
+xo_init_make_border (SDL_Surface **surfaces, SDL_Surface *board, int col,
+                     int row, const struct xo_mnk_geometry *geometry)
+{
+  int32_t result = 0;
+  /* Squares take the pieces of the 3x3 square they stand for: 0 on the first
+   * column or row, 2 on the last and 1 in between */
+  int col_part = col == 0 ? 0 : col == geometry->width - 1 ? 2 : 1;
+  int row_part = row == 0 ? 0 : row == geometry->height - 1 ? 2 : 1;
+  switch (col_part)
+    {
+    case 0:
+      switch (row_part)
+        {
+        case 0:
+          {
+            // square 0,0
+            SDL_Rect border_dest1
                 = (SDL_Rect){ .w = XO_TILE_SIZE,
                               .h = XO_TILE_SIZE,
                               .x = (col * XO_TILE_SIZE) + XO_BORDER,
@@ -564,7 +1702,7 @@ xo_init_make_border (SDL_Surface **surfaces, SDL_Surface *board, int col,
         }
       break;
     case 1:
-      switch (row)
+      switch (row_part)
         {
         case 0:
           {
@@ -613,7 +1751,7 @@ xo_init_make_border (SDL_Surface **surfaces, SDL_Surface *board, int col,
         }
       break;
     case 2:
-      switch (row)
+      switch (row_part)
         {
         case 0:
           {
@@ -723,9 +1861,11 @@ xo_init_make_board (struct xo_app *app, SDL_Surface *surfaces[])
   // Alloc memory for the board struct within game
   app->game->board = (struct xo_board *)calloc (1, sizeof (struct xo_board));
 
+  const struct xo_mnk_geometry *geometry = &app->game->geometry;
   SDL_Surface *board = SDL_CreateRGBSurfaceWithFormat (
-      0, (XO_TILE_SIZE * XO_BOARD_SIZE) + XO_BORDER,
-      (XO_TILE_SIZE * XO_BOARD_SIZE) + XO_BORDER, 32, SDL_PIXELFORMAT_RGBA32);
+      0, (XO_TILE_SIZE * geometry->width) + XO_BORDER,
+      (XO_TILE_SIZE * geometry->height) + XO_BORDER, 32,
+      SDL_PIXELFORMAT_RGBA32);
 
   if (board == NULL)
     {
@@ -735,18 +1875,9 @@ xo_init_make_board (struct xo_app *app, SDL_Surface *surfaces[])
       return 1;
     }
 
-  app->game->board->data
-      = (struct xo_board_data *)calloc (1, sizeof (struct xo_board_data));
-  if (app->game->board->data == NULL)
-    {
-      return 1;
-    }
-
-  memset (app->game->board->data->squares, 0x1, sizeof (uint8_t) * 9);
-
-  for (int col = 0; col < 3; col++)
+  for (int col = 0; col < geometry->width; col++)
     {
-      for (int row = 0; row < 3; row++)
+      for (int row = 0; row < geometry->height; row++)
         {
           SDL_Rect dest
               = (SDL_Rect){ .w = XO_TILE_SIZE,
@@ -758,11 +1889,11 @@ xo_init_make_board (struct xo_app *app, SDL_Surface *surfaces[])
           SDL_BlitSurface (surfaces[0], NULL, board, &dest);
         }
     }
-  for (int col = 0; col < 3; col++)
+  for (int col = 0; col < geometry->width; col++)
     {
-      for (int row = 0; row < 3; row++)
+      for (int row = 0; row < geometry->height; row++)
         {
-          xo_init_make_border (surfaces, board, col, row);
+          xo_init_make_border (surfaces, board, col, row, geometry);
         }
     }
 
@@ -1107,409 +2238,8086 @@ xo_init_load_images (struct xo_app *app)
   xo_init_cleanup_images ((SDL_Point){ cols, rows }, surface_pieces);
   return 0;
 }
+#endif
 
 /// BITWISE FUNCTIONS
 
 /*
- * These functions act on the board_data structure which contains an array 3x3
- * or uint8. These uint8 encode information about the 9 tic tac toe squares.
- * You can use the bitwise function to set, clear, check or void a square.
- */
-
-/**
- *
- * @param board_data
- * @param bit
- * @param col
- * @param row
+ * These functions act on the board_data structure which contains one 9-bit
+ * occupancy mask per side. You can use the bitwise function to set, clear,
+ * check or void a square.
  */
-static void
-xo_board_bit_set_at (struct xo_board_data *board_data,
-                     enum xo_bit_meaning_type bit, int col, int row)
-{
-  board_data->squares[col][row] |= bit;
-}
-
-static void
-xo_board_bit_clear_at (struct xo_board_data *board_data,
-                       enum xo_bit_meaning_type bit, int col, int row)
-{
-  board_data->squares[col][row] &= ~bit;
-}
 
-static SDL_bool
-xo_board_bit_check_at (struct xo_board_data *board,
-                       enum xo_bit_meaning_type bit, int col, int row)
-{
-  return (board->squares[col][row] & bit) != 0;
-}
+/* The 8 winning lines as occupancy masks: rows, columns, then diagonals. */
+static const uint16_t xo_board_win_masks[XO_BOARD_LINE_COUNT] = {
+  0x007, 0x038, 0x1C0, /* Rows */
+  0x049, 0x092, 0x124, /* Columns */
+  0x111, 0x054,        /* Diagonals */
+};
 
-static void
-xo_board_bit_void (struct xo_board_data *board, int col, int row)
-{
-  board->squares[col][row] = XO_BIT_MEANING_EMPTY;
-}
+/* For each square, one count (1 << 2 * line) for every winning line going
+ * through it. Adding it to a *_lines field records a piece on the square. */
+static const uint16_t xo_board_line_increments[XO_BOARD_SQUARES] = {
+  0x1041, 0x0101, 0x4401, /* Top row */
+  0x0044, 0x5104, 0x0404, /* Middle row */
+  0x4050, 0x0110, 0x1410, /* Bottom row */
+};
 
 /**
- * Verifies if the board is full. When this information is relevant, it is when
- * it would indicate a tie most of the time.
+ * Recomputes the per-line counts of a position from its occupancy masks.
+ * Needed after building a position directly from masks.
  * @param board_data
- * @return
  */
-static SDL_bool
-xo_board_check_if_full (struct xo_board_data *board_data)
+static void
+xo_board_count_lines (struct xo_board_data *board_data)
 {
-  SDL_bool is_full = SDL_TRUE;
-  for (uint8_t col = 0; col < XO_BOARD_SIZE; col++)
+  board_data->x_lines = 0;
+  board_data->o_lines = 0;
+  for (uint8_t square = 0; square < XO_BOARD_SQUARES; square++)
     {
-      for (uint8_t row = 0; row < XO_BOARD_SIZE; row++)
+      if ((board_data->x & (1u << square)) != 0)
         {
-          if (xo_board_bit_check_at (board_data, XO_BIT_MEANING_EMPTY, col,
-                                     row)
-              == SDL_TRUE)
-            {
-              is_full = SDL_FALSE;
-            }
+          board_data->x_lines
+              = (uint16_t)(board_data->x_lines
+                           + xo_board_line_increments[square]);
+        }
+      else if ((board_data->o & (1u << square)) != 0)
+        {
+          board_data->o_lines
+              = (uint16_t)(board_data->o_lines
+                           + xo_board_line_increments[square]);
         }
     }
-  return is_full;
 }
 
 /**
- * Checks the three possible win condition for a side.
- * @param board_data Allows flexibility by checking any future board
+ * Places a piece on an empty square, in place.
+ * @param board_data
  * @param side Side (expecting the bit_meaning_type X or O)
- * @return SDL_TRUE (win) or SDL_FALSE (lose)
+ * @param square Square index (row * XO_BOARD_SIZE + col)
+ * @return SDL_TRUE if the move completes a line for side
  */
 static SDL_bool
-xo_board_validate_win_conditions_for (struct xo_board_data *board_data,
-                                      enum xo_bit_meaning_type side)
+xo_board_make_move (struct xo_board_data *board_data,
+                    enum xo_bit_meaning_type side, uint8_t square)
 {
-  /* Check columns */
-  SDL_bool column_win;
-  for (uint8_t row = 0; row < XO_BOARD_SIZE; row++)
-    {
-      column_win = SDL_TRUE;
-      for (uint8_t col = 0; col < XO_BOARD_SIZE && column_win; col++)
-        {
-          if (xo_board_bit_check_at (board_data, side, col, row) == SDL_FALSE)
-            {
-              column_win = SDL_FALSE;
-            }
-        }
-      if (column_win)
-        {
-          return SDL_TRUE;
-        }
-    }
-  /* Check rows */
-  /* Same as above except col-first order */
-  SDL_bool row_win;
-  for (uint8_t col = 0; col < XO_BOARD_SIZE; col++)
-    {
-      row_win = SDL_TRUE;
-      for (uint8_t row = 0; row < XO_BOARD_SIZE && row_win; row++)
-        {
-          if (xo_board_bit_check_at (board_data, side, col, row) == SDL_FALSE)
-            {
-              row_win = SDL_FALSE;
-            }
-        }
-      if (row_win)
-        {
-          return SDL_TRUE;
-        }
-    }
-
-  /* Check diagonals */
-  SDL_bool diag_win = SDL_TRUE;
-  for (uint8_t dia = 0; dia < XO_BOARD_SIZE; dia++)
-    {
-      if (xo_board_bit_check_at (board_data, side, dia, dia) == SDL_FALSE)
-        {
-          diag_win = SDL_FALSE;
-        }
-    }
-
-  if (diag_win)
-    {
-      return SDL_TRUE;
-    }
+  uint16_t increment = xo_board_line_increments[square];
+  uint16_t lines;
 
-  diag_win = SDL_TRUE;
-  for (uint8_t dia = 0; dia < XO_BOARD_SIZE; dia++)
+  if (side == XO_BIT_MEANING_SIDE_X)
     {
-      /* Order on column value start from the end of the board for diagonal 2.
-       */
-      if (xo_board_bit_check_at (board_data, side, XO_BOARD_SIZE - (dia + 1),
-                                 dia)
-          == SDL_FALSE)
-        {
-          diag_win = SDL_FALSE;
-        }
+      board_data->x |= (uint16_t)(1u << square);
+      lines = board_data->x_lines = (uint16_t)(board_data->x_lines + increment);
     }
-
-  if (diag_win)
+  else
     {
-      return SDL_TRUE;
+      board_data->o |= (uint16_t)(1u << square);
+      lines = board_data->o_lines = (uint16_t)(board_data->o_lines + increment);
     }
 
-  return SDL_FALSE;
+  /* A count of 3 has both bits set. Only the lines through square can have
+   * just been completed. */
+  return (lines & (lines >> 1) & increment) != 0;
 }
 
 /**
- * Renders the board by reading the content of board_data in game->board (of
- * app param).
- * @param app
+ * Takes back a move played by xo_board_make_move.
+ * @param board_data
+ * @param side
+ * @param square
  */
 static void
-xo_board_render (struct xo_app *app)
+xo_board_unmake_move (struct xo_board_data *board_data,
+                      enum xo_bit_meaning_type side, uint8_t square)
 {
+  uint16_t increment = xo_board_line_increments[square];
 
-  for (int col = 0; col < 3; col++)
+  if (side == XO_BIT_MEANING_SIDE_X)
     {
-      for (int row = 0; row < 3; row++)
-        {
-
-          SDL_Rect dest
-              = (SDL_Rect){ .w = XO_TILE_SIZE * 4,
-                            .h = XO_TILE_SIZE * 4,
-                            .x = (col * XO_TILE_SIZE * 4) - XO_BORDER / 2,
-                            .y = (row * XO_TILE_SIZE * 4) - XO_BORDER };
-
-          // Draw the board square at (x, y)
-          if ((app->game->board->data->squares[col][row]
-               & XO_BIT_MEANING_EMPTY)
-              == XO_BIT_MEANING_EMPTY)
-            {
-            }
-          else
-            {
-              if ((app->game->board->data->squares[col][row]
-                   & XO_BIT_MEANING_SIDE_X)
-                  == XO_BIT_MEANING_SIDE_X)
-                {
-                  SDL_RenderCopy (app->renderer, app->game->Xs, NULL, &dest);
-                }
-              else if ((app->game->board->data->squares[col][row]
-                        & XO_BIT_MEANING_SIDE_O)
-                       == XO_BIT_MEANING_SIDE_O)
-                {
-                  SDL_RenderCopy (app->renderer, app->game->Os, NULL, &dest);
-                }
-            }
-        }
+      board_data->x &= (uint16_t)~(1u << square);
+      board_data->x_lines = (uint16_t)(board_data->x_lines - increment);
+    }
+  else
+    {
+      board_data->o &= (uint16_t)~(1u << square);
+      board_data->o_lines = (uint16_t)(board_data->o_lines - increment);
     }
 }
 
 /**
- * Returns an enum indicating the current win_state of the provided board. Can
- * be used to decide if the real game is over OR during AI prediction.
- * @param board_data
+ * Converts square coordinates to the matching bit of an occupancy mask.
+ * @param col
+ * @param row
  * @return
  */
-static enum xo_win_state_type
+static uint16_t
+xo_board_square_bit (int col, int row)
+{
+  return (uint16_t)(1u << (row * XO_BOARD_SIZE + col));
+}
+
+static void
+xo_board_bit_clear_at (struct xo_board_data *board_data,
+                       enum xo_bit_meaning_type bit, int col, int row)
+{
+  uint16_t square = xo_board_square_bit (col, row);
+  uint16_t pieces
+      = bit == XO_BIT_MEANING_SIDE_X ? board_data->x : board_data->o;
+  switch (bit)
+    {
+    case XO_BIT_MEANING_SIDE_X:
+    case XO_BIT_MEANING_SIDE_O:
+      if ((pieces & square) != 0)
+        {
+          xo_board_unmake_move (board_data, bit,
+                                (uint8_t)(row * XO_BOARD_SIZE + col));
+        }
+      break;
+    case XO_BIT_MEANING_EMPTY:
+      /* Emptiness is derived from the side masks */
+    case XO_BIT_MEANING_HOVER:
+    case XO_BIT_MEANING_CLICK:
+    default:
+      break;
+    }
+}
+
+/**
+ *
+ * @param board_data
+ * @param bit
+ * @param col
+ * @param row
+ */
+static void
+xo_board_bit_set_at (struct xo_board_data *board_data,
+                     enum xo_bit_meaning_type bit, int col, int row)
+{
+  uint16_t square = xo_board_square_bit (col, row);
+  switch (bit)
+    {
+    case XO_BIT_MEANING_EMPTY:
+      xo_board_bit_clear_at (board_data, XO_BIT_MEANING_SIDE_X, col, row);
+      xo_board_bit_clear_at (board_data, XO_BIT_MEANING_SIDE_O, col, row);
+      break;
+    case XO_BIT_MEANING_SIDE_X:
+    case XO_BIT_MEANING_SIDE_O:
+      if (((board_data->x | board_data->o) & square) == 0)
+        {
+          xo_board_make_move (board_data, bit,
+                              (uint8_t)(row * XO_BOARD_SIZE + col));
+        }
+      break;
+    case XO_BIT_MEANING_HOVER:
+    case XO_BIT_MEANING_CLICK:
+    default:
+      /* UI flags live in xo_board_ui */
+      break;
+    }
+}
+
+static void
+xo_board_bit_void (struct xo_board_data *board, int col, int row)
+{
+  xo_board_bit_set_at (board, XO_BIT_MEANING_EMPTY, col, row);
+}
+
+/**
+ * Verifies if the board is full. When this information is relevant, it is when
+ * it would indicate a tie most of the time.
+ * @param board_data
+ * @return
+ */
+static SDL_bool
+xo_board_check_if_full (struct xo_board_data *board_data)
+{
+  return (board_data->x | board_data->o) == XO_BOARD_FULL_MASK;
+}
+
+/**
+ * Counts the empty squares of a board, which is also the most plies a game
+ * can still last.
+ * @param board_data
+ * @return
+ */
+static uint8_t
+xo_board_empty_count (const struct xo_board_data *board_data)
+{
+  return (uint8_t)(XO_BOARD_SQUARES
+                   - xo_util_bit_count (board_data->x | board_data->o));
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Computes the base-3 encoding of a position (digit 0 empty, 1 X, 2 O, square
+ * 0 least significant). Every raw 3x3 position has its own index below
+ * XO_TABLE_SIZE.
+ * @param board_data
+ * @return
+ */
+static uint16_t
+xo_board_index (struct xo_board_data *board_data)
+{
+  uint16_t index = 0;
+  for (int8_t square = XO_BOARD_SQUARES - 1; square >= 0; square--)
+    {
+      index = (uint16_t)(index * 3);
+      if ((board_data->x & (1u << square)) != 0)
+        {
+          index = (uint16_t)(index + 1);
+        }
+      else if ((board_data->o & (1u << square)) != 0)
+        {
+          index = (uint16_t)(index + 2);
+        }
+    }
+  return index;
+}
+#endif
+
+/**
+ * Checks the eight possible win lines for a side.
+ * @param board_data Allows flexibility by checking any future board
+ * @param side Side (expecting the bit_meaning_type X or O)
+ * @return SDL_TRUE (win) or SDL_FALSE (lose)
+ */
+static SDL_bool
+xo_board_validate_win_conditions_for (struct xo_board_data *board_data,
+                                      enum xo_bit_meaning_type side)
+{
+  uint16_t pieces
+      = side == XO_BIT_MEANING_SIDE_X ? board_data->x : board_data->o;
+
+  for (uint8_t line = 0; line < XO_BOARD_LINE_COUNT; line++)
+    {
+      if ((pieces & xo_board_win_masks[line]) == xo_board_win_masks[line])
+        {
+          return SDL_TRUE;
+        }
+    }
+
+  return SDL_FALSE;
+}
+
+/// SYMMETRY FUNCTIONS
+
+/*
+ * Positions that only differ by a rotation or a reflection of the board have
+ * the same value, and their best moves are images of each other. These
+ * functions are the position counterpart of xo_util_rotate_surface,
+ * xo_util_surface_mirror and xo_util_surface_flip: they move pieces around
+ * instead of pixels, so that the CPU can treat up to 8 positions as one.
+ */
+
+/* Image of each square under each xo_board_symmetry_type. */
+static const uint8_t xo_board_symmetry_squares[XO_BOARD_SYMMETRIES]
+                                              [XO_BOARD_SQUARES]
+    = {
+        { 0, 1, 2, 3, 4, 5, 6, 7, 8 }, /* Identity */
+        { 2, 5, 8, 1, 4, 7, 0, 3, 6 }, /* Rotate 90 */
+        { 8, 7, 6, 5, 4, 3, 2, 1, 0 }, /* Rotate 180 */
+        { 6, 3, 0, 7, 4, 1, 8, 5, 2 }, /* Rotate 270 */
+        { 2, 1, 0, 5, 4, 3, 8, 7, 6 }, /* Mirror */
+        { 6, 7, 8, 3, 4, 5, 0, 1, 2 }, /* Flip */
+        { 0, 3, 6, 1, 4, 7, 2, 5, 8 }, /* Transpose */
+        { 8, 5, 2, 7, 4, 1, 6, 3, 0 }, /* Anti-transpose */
+      };
+
+/* Transform undoing each xo_board_symmetry_type. */
+static const uint8_t xo_board_symmetry_inverse[XO_BOARD_SYMMETRIES]
+    = { XO_BOARD_SYMMETRY_IDENTITY,       XO_BOARD_SYMMETRY_ROTATE_270,
+        XO_BOARD_SYMMETRY_ROTATE_180,     XO_BOARD_SYMMETRY_ROTATE_90,
+        XO_BOARD_SYMMETRY_MIRROR,         XO_BOARD_SYMMETRY_FLIP,
+        XO_BOARD_SYMMETRY_TRANSPOSE,      XO_BOARD_SYMMETRY_ANTI_TRANSPOSE };
+
+/* Image of every 9-bit occupancy mask under each symmetry, filled by
+ * xo_board_init_symmetries. */
+static uint16_t xo_board_symmetry_masks[XO_BOARD_SYMMETRIES]
+                                       [XO_BOARD_FULL_MASK + 1];
+
+/**
+ * Precomputes xo_board_symmetry_masks. Must be called once before any other
+ * symmetry function.
+ */
+static void
+xo_board_init_symmetries (void)
+{
+  for (uint8_t transform = 0; transform < XO_BOARD_SYMMETRIES; transform++)
+    {
+      for (uint16_t mask = 0; mask <= XO_BOARD_FULL_MASK; mask++)
+        {
+          uint16_t image = 0;
+          for (uint8_t square = 0; square < XO_BOARD_SQUARES; square++)
+            {
+              if ((mask & (1u << square)) != 0)
+                {
+                  image |= (uint16_t)(
+                      1u << xo_board_symmetry_squares[transform][square]);
+                }
+            }
+          xo_board_symmetry_masks[transform][mask] = image;
+        }
+    }
+}
+
+/**
+ * Applies one of the board symmetries to a position.
+ * @param board_data
+ * @param transform A xo_board_symmetry_type
+ * @return The transformed position
+ */
+static struct xo_board_data
+xo_board_transform (struct xo_board_data *board_data, uint8_t transform)
+{
+  struct xo_board_data image = {
+    .x = xo_board_symmetry_masks[transform][board_data->x],
+    .o = xo_board_symmetry_masks[transform][board_data->o],
+  };
+  xo_board_count_lines (&image);
+  return image;
+}
+
+/**
+ * Maps a position to the representative of its symmetry class: the image
+ * whose masks, read as the number (x | o << 9), are the smallest. All
+ * positions of a class share the same representative.
+ * @param board_data
+ * @param canonical Receives the representative
+ * @return The xo_board_symmetry_type taking board_data to canonical. Moves
+ * found on canonical are mapped back through xo_board_symmetry_inverse.
+ */
+static uint8_t
+xo_board_canonicalize (struct xo_board_data *board_data,
+                       struct xo_board_data *canonical)
+{
+  uint8_t best_transform = XO_BOARD_SYMMETRY_IDENTITY;
+  uint32_t best_code = UINT32_MAX;
+
+  *canonical = *board_data;
+  for (uint8_t transform = 0; transform < XO_BOARD_SYMMETRIES; transform++)
+    {
+      struct xo_board_data image = xo_board_transform (board_data, transform);
+      uint32_t code = (uint32_t)image.x | ((uint32_t)image.o << 9);
+      if (code < best_code)
+        {
+          best_code = code;
+          best_transform = transform;
+          *canonical = image;
+        }
+    }
+
+  return best_transform;
+}
+
+/**
+ * Finds the symmetries leaving a position unchanged. Moves that are images of
+ * each other under these symmetries lead to equivalent positions.
+ * @param board_data
+ * @return One bit per xo_board_symmetry_type (the identity is always set)
+ */
+static uint8_t
+xo_board_symmetry_stabilizer (struct xo_board_data *board_data)
+{
+  uint8_t symmetries = 0;
+  for (uint8_t transform = 0; transform < XO_BOARD_SYMMETRIES; transform++)
+    {
+      if (xo_board_symmetry_masks[transform][board_data->x] == board_data->x
+          && xo_board_symmetry_masks[transform][board_data->o]
+                 == board_data->o)
+        {
+          symmetries |= (uint8_t)(1u << transform);
+        }
+    }
+  return symmetries;
+}
+
+/// M,N,K BOARDS
+
+/*
+ * Boards of any size up to XO_MNK_MAX_SIZE, for the solvers. Each side owns a
+ * bit set, and a line of k is found by shift-and-AND: ANDing a bit set with
+ * itself shifted by one step along a direction leaves the cells that start two
+ * in a row, and doubling the run length each time reaches k in about log2(k)
+ * steps per direction.
+ */
+
+/* Zobrist keys of the m,n,k cells, one per side and bit, plus one that is
+ * mixed in when X is to move. */
+static uint64_t xo_mnk_zobrist[2][XO_MNK_BITS];
+static uint64_t xo_mnk_zobrist_side;
+
+/* Image of each cell under the symmetries of the current board, in
+ * xo_board_symmetry_type order. A rectangular board only has the first
+ * geometry.symmetry_count: the identity, the half turn, the mirror and the
+ * flip, which are stored in that order. */
+static uint16_t xo_mnk_symmetry_bits[XO_BOARD_SYMMETRIES][XO_MNK_BITS];
+
+/**
+ * Sets up the geometry of an m,n,k game.
+ * @param geometry
+ * @param width
+ * @param height
+ * @param k Length of a winning line
+ * @return 0 for success, 1 if the board is too large or k does not fit on it
+ */
+static int32_t
+xo_mnk_geometry_init (struct xo_mnk_geometry *geometry, uint8_t width,
+                      uint8_t height, uint8_t k)
+{
+  if (width < 1 || height < 1 || width > XO_MNK_MAX_SIZE
+      || height > XO_MNK_MAX_SIZE || k < 1 || k > SDL_max (width, height))
+    {
+      xo_log_error (SDL_FALSE, "Unsupported board %ux%u with k=%u\n", width,
+                    height, k);
+      return 1;
+    }
+
+  *geometry = (struct xo_mnk_geometry){ 0 };
+  geometry->width = width;
+  geometry->height = height;
+  geometry->k = k;
+  geometry->stride = (uint8_t)(width + 1);
+  geometry->cells = (uint16_t)(width * height);
+  geometry->word_count = (uint8_t)((geometry->stride * height + 63) / 64);
+  geometry->symmetry_count = width == height ? XO_BOARD_SYMMETRIES : 4;
+
+  static const enum xo_board_symmetry_type rectangle_symmetries[]
+      = { XO_BOARD_SYMMETRY_IDENTITY, XO_BOARD_SYMMETRY_ROTATE_180,
+          XO_BOARD_SYMMETRY_MIRROR, XO_BOARD_SYMMETRY_FLIP };
+  for (uint8_t row = 0; row < height; row++)
+    {
+      for (uint8_t col = 0; col < width; col++)
+        {
+          uint16_t bit = (uint16_t)(row * geometry->stride + col);
+          geometry->full.words[bit / 64] |= 1ull << (bit % 64);
+
+          for (uint8_t i = 0; i < geometry->symmetry_count; i++)
+            {
+              int last_col = width - 1;
+              int last_row = height - 1;
+              int image[XO_BOARD_SYMMETRIES][2]
+                  = { { col, row },
+                      { last_row - row, col },
+                      { last_col - col, last_row - row },
+                      { row, last_col - col },
+                      { last_col - col, row },
+                      { col, last_row - row },
+                      { row, col },
+                      { last_row - row, last_col - col } };
+              enum xo_board_symmetry_type transform
+                  = width == height ? (enum xo_board_symmetry_type)i
+                                    : rectangle_symmetries[i];
+              xo_mnk_symmetry_bits[i][bit]
+                  = (uint16_t)(image[transform][1] * geometry->stride
+                               + image[transform][0]);
+            }
+        }
+    }
+
+  uint64_t seed = 0x584F5F4D4E4B21ull;
+  for (uint8_t side = 0; side < 2; side++)
+    {
+      for (uint16_t bit = 0; bit < XO_MNK_BITS; bit++)
+        {
+          xo_mnk_zobrist[side][bit] = xo_util_splitmix64 (&seed);
+        }
+    }
+  xo_mnk_zobrist_side = xo_util_splitmix64 (&seed);
+  return 0;
+}
+
+/**
+ * Checks a cell of a bit set.
+ * @param bits
+ * @param bit
+ * @return
+ */
+XO_INLINE SDL_bool
+xo_mnk_bits_test (const struct xo_mnk_bits *bits, uint16_t bit)
+{
+  return (bits->words[bit / 64] >> (bit % 64)) & 1 ? SDL_TRUE : SDL_FALSE;
+}
+
+/**
+ * Flips a cell of a bit set, which both plays and takes back a piece.
+ * @param bits
+ * @param bit
+ */
+XO_INLINE void
+xo_mnk_bits_toggle (struct xo_mnk_bits *bits, uint16_t bit)
+{
+  bits->words[bit / 64] ^= 1ull << (bit % 64);
+}
+
+/**
+ * Keeps the cells of a bit set whose cell shift bits further is also set.
+ * @param bits Bit set to narrow
+ * @param shift
+ * @param word_count Words in use
+ */
+XO_INLINE void
+xo_mnk_bits_and_shifted (struct xo_mnk_bits *bits, uint16_t shift,
+                         uint8_t word_count)
+{
+  uint16_t word_shift = shift / 64;
+  uint16_t bit_shift = shift % 64;
+  for (uint16_t word = 0; word < word_count; word++)
+    {
+      uint16_t from = (uint16_t)(word + word_shift);
+      uint64_t shifted = 0;
+      if (from < word_count)
+        {
+          shifted = bits->words[from] >> bit_shift;
+          if (bit_shift != 0 && from + 1 < word_count)
+            {
+              shifted |= bits->words[from + 1] << (64 - bit_shift);
+            }
+        }
+      bits->words[word] &= shifted;
+    }
+}
+
+/**
+ * Tests if a bit set holds k cells in a row in any direction.
+ * @param geometry
+ * @param pieces Cells of one side
+ * @return
+ */
+XO_INLINE SDL_bool
+xo_mnk_has_line (const struct xo_mnk_geometry *geometry,
+                 const struct xo_mnk_bits *pieces)
+{
+  const uint16_t steps[4]
+      = { 1, geometry->stride, (uint16_t)(geometry->stride + 1),
+          (uint16_t)(geometry->stride - 1) };
+
+  for (uint8_t direction = 0; direction < 4; direction++)
+    {
+      /* run holds the cells that start `length` pieces in a row */
+      struct xo_mnk_bits run = *pieces;
+      uint8_t length = 1;
+      while (length < geometry->k)
+        {
+          uint8_t grow = (uint8_t)SDL_min (length, geometry->k - length);
+          xo_mnk_bits_and_shifted (&run, (uint16_t)(grow * steps[direction]),
+                                   geometry->word_count);
+          length = (uint8_t)(length + grow);
+        }
+
+      for (uint8_t word = 0; word < geometry->word_count; word++)
+        {
+          if (run.words[word] != 0)
+            {
+              return SDL_TRUE;
+            }
+        }
+    }
+  return SDL_FALSE;
+}
+
+/**
+ * Moves every cell of a bit set shift bits down, towards bit 0: cell i of the
+ * result is cell i + shift of bits.
+ * @param bits
+ * @param shift
+ * @param word_count Words in use
+ * @param shifted Receives the result
+ */
+XO_INLINE void
+xo_mnk_bits_shift_down (const struct xo_mnk_bits *bits, uint16_t shift,
+                        uint8_t word_count, struct xo_mnk_bits *shifted)
+{
+  uint16_t word_shift = shift / 64;
+  uint16_t bit_shift = shift % 64;
+  for (uint16_t word = 0; word < word_count; word++)
+    {
+      uint16_t from = (uint16_t)(word + word_shift);
+      shifted->words[word] = 0;
+      if (from < word_count)
+        {
+          shifted->words[word] = bits->words[from] >> bit_shift;
+          if (bit_shift != 0 && from + 1 < word_count)
+            {
+              shifted->words[word] |= bits->words[from + 1]
+                                      << (64 - bit_shift);
+            }
+        }
+    }
+}
+
+/**
+ * Adds to a bit set the cells of another, moved shift bits up: cell i of
+ * bits sets cell i + shift of target.
+ * @param target
+ * @param bits
+ * @param shift
+ * @param word_count Words in use
+ */
+XO_INLINE void
+xo_mnk_bits_or_shifted_up (struct xo_mnk_bits *target,
+                           const struct xo_mnk_bits *bits, uint16_t shift,
+                           uint8_t word_count)
+{
+  uint16_t word_shift = shift / 64;
+  uint16_t bit_shift = shift % 64;
+  for (uint16_t from = 0; from + word_shift < word_count; from++)
+    {
+      uint16_t word = (uint16_t)(from + word_shift);
+      target->words[word] |= bits->words[from] << bit_shift;
+      if (bit_shift != 0 && from > 0)
+        {
+          target->words[word] |= bits->words[from - 1] >> (64 - bit_shift);
+        }
+    }
+}
+
+/**
+ * Counts the cells of a bit set.
+ * @param bits
+ * @param word_count Words in use
+ * @return
+ */
+XO_INLINE uint16_t
+xo_mnk_bits_count (const struct xo_mnk_bits *bits, uint8_t word_count)
+{
+  uint16_t count = 0;
+  for (uint8_t word = 0; word < word_count; word++)
+    {
+      for (uint64_t rest = bits->words[word]; rest != 0; rest &= rest - 1)
+        {
+          count++;
+        }
+    }
+  return count;
+}
+
+/**
+ * Finds the first cell of a bit set from a given bit on, to walk through the
+ * cells of a set.
+ * @param bits
+ * @param from First bit to look at
+ * @param word_count Words in use
+ * @return The bit of the cell, or XO_MNK_BITS if there is none
+ */
+XO_INLINE uint16_t
+xo_mnk_bits_next (const struct xo_mnk_bits *bits, uint16_t from,
+                  uint8_t word_count)
+{
+  for (uint16_t word = from / 64; word < word_count; word++)
+    {
+      uint64_t rest = bits->words[word];
+      if (word == from / 64)
+        {
+          rest &= ~0ull << (from % 64);
+        }
+      if (rest != 0)
+        {
+          uint16_t bit = (uint16_t)(word * 64);
+          for (; (rest & 1) == 0; rest >>= 1)
+            {
+              bit++;
+            }
+          return bit;
+        }
+    }
+  return XO_MNK_BITS;
+}
+
+/**
+ * Finds the empty cells that lie in a line of k cells where a side has every
+ * other cell and exactly missing cells are empty. With missing at 1, these
+ * are the cells where the side wins by playing; at 2, the cells where it makes
+ * a four (a threat to win on the next move), at 3 the cells where it makes a
+ * three. Like xo_mnk_has_line, it is done for the whole board at once: the
+ * pieces and the empty cells are shifted 0 to k - 1 steps along each
+ * direction, so that bit i of shift j tells about the j-th cell of the line
+ * starting at cell i, and a line matches when the right shifts are ANDed.
+ * @param geometry
+ * @param own Pieces of the side
+ * @param empty Empty cells
+ * @param missing 1, 2 or 3
+ * @param cells Receives the cells
+ */
+XO_INLINE void
+xo_mnk_completions (const struct xo_mnk_geometry *geometry,
+                    const struct xo_mnk_bits *own,
+                    const struct xo_mnk_bits *empty, uint8_t missing,
+                    struct xo_mnk_bits *cells)
+{
+  const uint16_t steps[4]
+      = { 1, geometry->stride, (uint16_t)(geometry->stride + 1),
+          (uint16_t)(geometry->stride - 1) };
+  uint8_t k = geometry->k;
+  uint8_t word_count = geometry->word_count;
+  struct xo_mnk_bits own_shifts[XO_MNK_MAX_SIZE];
+  struct xo_mnk_bits empty_shifts[XO_MNK_MAX_SIZE];
+
+  *cells = (struct xo_mnk_bits){ 0 };
+  if (missing < 1 || missing > 3 || missing > k)
+    {
+      return;
+    }
+
+  for (uint8_t direction = 0; direction < 4; direction++)
+    {
+      for (uint8_t i = 0; i < k; i++)
+        {
+          uint16_t shift = (uint16_t)(i * steps[direction]);
+          xo_mnk_bits_shift_down (own, shift, word_count, &own_shifts[i]);
+          xo_mnk_bits_shift_down (empty, shift, word_count, &empty_shifts[i]);
+        }
+
+      /* Every choice of the missing cells among the k of a line, as
+       * offsets a < b < c, the unused ones left at k */
+      uint8_t last_b = missing >= 2 ? k - 1 : k;
+      uint8_t last_c = missing >= 3 ? k - 1 : k;
+      for (uint8_t a = 0; a + missing <= k; a++)
+        {
+          for (uint8_t b = missing >= 2 ? a + 1 : k; b <= last_b; b++)
+            {
+              for (uint8_t c = missing >= 3 ? b + 1 : k; c <= last_c; c++)
+                {
+                  struct xo_mnk_bits starts;
+                  SDL_bool b_any = SDL_FALSE;
+                  for (uint8_t word = 0; word < word_count; word++)
+                    {
+                      uint64_t match = ~0ull;
+                      for (uint8_t i = 0; i < k; i++)
+                        {
+                          match &= i == a || i == b || i == c
+                                       ? empty_shifts[i].words[word]
+                                       : own_shifts[i].words[word];
+                        }
+                      starts.words[word] = match;
+                      b_any = b_any || match != 0;
+                    }
+                  if (!b_any)
+                    {
+                      continue;
+                    }
+
+                  xo_mnk_bits_or_shifted_up (
+                      cells, &starts, (uint16_t)(a * steps[direction]),
+                      word_count);
+                  if (b < k)
+                    {
+                      xo_mnk_bits_or_shifted_up (
+                          cells, &starts, (uint16_t)(b * steps[direction]),
+                          word_count);
+                    }
+                  if (c < k)
+                    {
+                      xo_mnk_bits_or_shifted_up (
+                          cells, &starts, (uint16_t)(c * steps[direction]),
+                          word_count);
+                    }
+                }
+            }
+        }
+    }
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Finds the empty cells where a side would make two fours at once: cells that
+ * share a line of k cells, where the side has every other cell, with two or
+ * more different empty cells. Like xo_mnk_completions, the lines are found for
+ * the whole board at once, and each cell of a line with two empty cells is
+ * marked in a bit set per direction and offset to the other empty cell.
+ * Different sets mean different fours, so the cells found are the ones in two
+ * sets or more.
+ * @param geometry
+ * @param own Pieces of the side
+ * @param empty Empty cells
+ * @param cells Receives the cells
+ */
+static void
+xo_mnk_double_fours (const struct xo_mnk_geometry *geometry,
+                     const struct xo_mnk_bits *own,
+                     const struct xo_mnk_bits *empty,
+                     struct xo_mnk_bits *cells)
+{
+  const uint16_t steps[4]
+      = { 1, geometry->stride, (uint16_t)(geometry->stride + 1),
+          (uint16_t)(geometry->stride - 1) };
+  uint8_t k = geometry->k;
+  uint8_t word_count = geometry->word_count;
+  struct xo_mnk_bits own_shifts[XO_MNK_MAX_SIZE];
+  struct xo_mnk_bits empty_shifts[XO_MNK_MAX_SIZE];
+  struct xo_mnk_bits once = { 0 };
+
+  *cells = (struct xo_mnk_bits){ 0 };
+  if (k < 2)
+    {
+      return;
+    }
+
+  for (uint8_t direction = 0; direction < 4; direction++)
+    {
+      for (uint8_t i = 0; i < k; i++)
+        {
+          uint16_t shift = (uint16_t)(i * steps[direction]);
+          xo_mnk_bits_shift_down (own, shift, word_count, &own_shifts[i]);
+          xo_mnk_bits_shift_down (empty, shift, word_count, &empty_shifts[i]);
+        }
+
+      /* partners[0][d - 1] holds the cells whose other empty cell is d steps
+       * further, partners[1][d - 1] the ones where it is d steps back */
+      struct xo_mnk_bits partners[2][XO_MNK_MAX_SIZE] = { 0 };
+      for (uint8_t a = 0; a + 1 < k; a++)
+        {
+          for (uint8_t b = (uint8_t)(a + 1); b < k; b++)
+            {
+              struct xo_mnk_bits starts;
+              SDL_bool b_any = SDL_FALSE;
+              for (uint8_t word = 0; word < word_count; word++)
+                {
+                  uint64_t match = ~0ull;
+                  for (uint8_t i = 0; i < k; i++)
+                    {
+                      match &= i == a || i == b ? empty_shifts[i].words[word]
+                                                : own_shifts[i].words[word];
+                    }
+                  starts.words[word] = match;
+                  b_any = b_any || match != 0;
+                }
+              if (b_any)
+                {
+                  xo_mnk_bits_or_shifted_up (
+                      &partners[0][b - a - 1], &starts,
+                      (uint16_t)(a * steps[direction]), word_count);
+                  xo_mnk_bits_or_shifted_up (
+                      &partners[1][b - a - 1], &starts,
+                      (uint16_t)(b * steps[direction]), word_count);
+                }
+            }
+        }
+
+      for (uint8_t side = 0; side < 2; side++)
+        {
+          for (uint8_t i = 0; i + 1 < k; i++)
+            {
+              for (uint8_t word = 0; word < word_count; word++)
+                {
+                  cells->words[word]
+                      |= once.words[word] & partners[side][i].words[word];
+                  once.words[word] |= partners[side][i].words[word];
+                }
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * Tells whether a geometry is the 3x3 board with 3 in a row, which the CPU
+ * plays with the xo_board_data engine and its tables.
+ * @param geometry
+ * @return
+ */
+static SDL_bool
+xo_mnk_is_tic_tac_toe (const struct xo_mnk_geometry *geometry)
+{
+  return geometry->width == XO_BOARD_SIZE && geometry->height == XO_BOARD_SIZE
+         && geometry->k == XO_BOARD_SIZE;
+}
+
+/**
+ * Converts cell coordinates to the matching bit of a bit set.
+ * @param geometry
+ * @param col
+ * @param row
+ * @return
+ */
+static uint16_t
+xo_mnk_cell_bit (const struct xo_mnk_geometry *geometry, int col, int row)
+{
+  return (uint16_t)(row * geometry->stride + col);
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Returns the state of an m,n,k game, with the shift-and-AND line test.
+ * @param geometry
+ * @param board
+ * @return
+ */
+static enum xo_win_state_type
+xo_mnk_board_final_state (const struct xo_mnk_geometry *geometry,
+                          const struct xo_mnk_board *board)
+{
+  if (xo_mnk_has_line (geometry, &board->x))
+    {
+      return XO_WIN_STATE_X_WIN;
+    }
+  if (xo_mnk_has_line (geometry, &board->o))
+    {
+      return XO_WIN_STATE_O_WIN;
+    }
+  if (board->count == geometry->cells)
+    {
+      return XO_WIN_STATE_TIE;
+    }
+  return XO_WIN_STATE_NONE;
+}
+
+/**
+ * Copies a 3x3 m,n,k board to the xo_board_data the 3x3 engine searches.
+ * @param geometry
+ * @param board
+ * @param board_data Receives the position
+ */
+static void
+xo_mnk_board_to_data (const struct xo_mnk_geometry *geometry,
+                      const struct xo_mnk_board *board,
+                      struct xo_board_data *board_data)
+{
+  *board_data = (struct xo_board_data){ 0 };
+  for (int row = 0; row < XO_BOARD_SIZE; row++)
+    {
+      for (int col = 0; col < XO_BOARD_SIZE; col++)
+        {
+          uint16_t bit = xo_mnk_cell_bit (geometry, col, row);
+          if (xo_mnk_bits_test (&board->x, bit))
+            {
+              xo_board_bit_set_at (board_data, XO_BIT_MEANING_SIDE_X, col,
+                                   row);
+            }
+          else if (xo_mnk_bits_test (&board->o, bit))
+            {
+              xo_board_bit_set_at (board_data, XO_BIT_MEANING_SIDE_O, col,
+                                   row);
+            }
+        }
+    }
+}
+
+/**
+ * Computes the Zobrist hash of an m,n,k position, with xo_mnk_zobrist.
+ * @param geometry
+ * @param board
+ * @param side Side to move
+ * @return
+ */
+static uint64_t
+xo_mnk_hash (const struct xo_mnk_geometry *geometry,
+             const struct xo_mnk_board *board, enum xo_bit_meaning_type side)
+{
+  uint8_t word_count = geometry->word_count;
+  uint64_t hash = side == XO_BIT_MEANING_SIDE_X ? xo_mnk_zobrist_side : 0;
+  for (uint16_t bit = xo_mnk_bits_next (&board->x, 0, word_count);
+       bit != XO_MNK_BITS;
+       bit = xo_mnk_bits_next (&board->x, (uint16_t)(bit + 1), word_count))
+    {
+      hash ^= xo_mnk_zobrist[0][bit];
+    }
+  for (uint16_t bit = xo_mnk_bits_next (&board->o, 0, word_count);
+       bit != XO_MNK_BITS;
+       bit = xo_mnk_bits_next (&board->o, (uint16_t)(bit + 1), word_count))
+    {
+      hash ^= xo_mnk_zobrist[1][bit];
+    }
+  return hash;
+}
+#endif
+
+/**
+ * Finds the empty cells next to a piece, in any of the eight directions.
+ * @param geometry
+ * @param occupied Cells of both sides
+ * @param cells Receives the cells
+ */
+XO_INLINE void
+xo_mnk_neighbours (const struct xo_mnk_geometry *geometry,
+                   const struct xo_mnk_bits *occupied,
+                   struct xo_mnk_bits *cells)
+{
+  const uint16_t steps[4]
+      = { 1, geometry->stride, (uint16_t)(geometry->stride + 1),
+          (uint16_t)(geometry->stride - 1) };
+  uint8_t word_count = geometry->word_count;
+
+  *cells = (struct xo_mnk_bits){ 0 };
+  for (uint8_t direction = 0; direction < 4; direction++)
+    {
+      struct xo_mnk_bits shifted;
+      xo_mnk_bits_shift_down (occupied, steps[direction], word_count,
+                              &shifted);
+      xo_mnk_bits_or_shifted_up (cells, occupied, steps[direction],
+                                 word_count);
+      for (uint8_t word = 0; word < word_count; word++)
+        {
+          cells->words[word] |= shifted.words[word];
+        }
+    }
+  for (uint8_t word = 0; word < word_count; word++)
+    {
+      cells->words[word]
+          &= geometry->full.words[word] & ~occupied->words[word];
+    }
+}
+
+/**
+ * Scores the lines of k cells a side can still complete, by how many of its
+ * pieces they hold. The pieces of each line are counted for the whole board
+ * at once: the shifted bit sets are added up in bit planes, one per bit of
+ * the count, like a binary adder works on single bits.
+ * @param geometry
+ * @param pieces Pieces of the side
+ * @param blockers Pieces of the other side
+ * @return
+ */
+XO_INLINE int32_t
+xo_mnk_line_score (const struct xo_mnk_geometry *geometry,
+                   const struct xo_mnk_bits *pieces,
+                   const struct xo_mnk_bits *blockers)
+{
+  const uint16_t steps[4]
+      = { 1, geometry->stride, (uint16_t)(geometry->stride + 1),
+          (uint16_t)(geometry->stride - 1) };
+  uint8_t word_count = geometry->word_count;
+  struct xo_mnk_bits open;
+  int32_t score = 0;
+
+  for (uint8_t word = 0; word < word_count; word++)
+    {
+      open.words[word] = geometry->full.words[word] & ~blockers->words[word];
+    }
+
+  for (uint8_t direction = 0; direction < 4; direction++)
+    {
+      /* Bit i of windows is set when the line starting at cell i has no
+       * blocker, and planes[j] holds bit j of its piece count */
+      uint64_t windows[XO_MNK_WORDS];
+      uint64_t planes[5][XO_MNK_WORDS] = { 0 };
+      for (uint8_t word = 0; word < word_count; word++)
+        {
+          windows[word] = ~0ull;
+        }
+      for (uint8_t i = 0; i < geometry->k; i++)
+        {
+          struct xo_mnk_bits shifted_open;
+          struct xo_mnk_bits shifted_pieces;
+          uint16_t shift = (uint16_t)(i * steps[direction]);
+          xo_mnk_bits_shift_down (&open, shift, word_count, &shifted_open);
+          xo_mnk_bits_shift_down (pieces, shift, word_count,
+                                  &shifted_pieces);
+          for (uint8_t word = 0; word < word_count; word++)
+            {
+              windows[word] &= shifted_open.words[word];
+              uint64_t carry = shifted_pieces.words[word];
+              for (uint8_t plane = 0; plane < 5 && carry != 0; plane++)
+                {
+                  uint64_t next = planes[plane][word] & carry;
+                  planes[plane][word] ^= carry;
+                  carry = next;
+                }
+            }
+        }
+
+      for (uint8_t count = 1; count < geometry->k; count++)
+        {
+          /* Longer lines are worth more, up to 8 pieces to stay in range */
+          int32_t weight = 1 << (2 * SDL_min (count, 8));
+          for (uint8_t word = 0; word < word_count; word++)
+            {
+              uint64_t match = windows[word];
+              for (uint8_t plane = 0; plane < 5; plane++)
+                {
+                  match &= (count >> plane) & 1 ? planes[plane][word]
+                                                : ~planes[plane][word];
+                }
+              for (; match != 0; match &= match - 1)
+                {
+                  score += weight;
+                }
+            }
+        }
+    }
+  return score;
+}
+
+/**
+ * Evaluates a position that is not over for the side to move.
+ * @param geometry
+ * @param own Pieces of the side to move
+ * @param other Pieces of the other side
+ * @return Positive when the side to move is better
+ */
+XO_INLINE int32_t
+xo_mnk_evaluate (const struct xo_mnk_geometry *geometry,
+                 const struct xo_mnk_bits *own,
+                 const struct xo_mnk_bits *other)
+{
+  int32_t score = xo_mnk_line_score (geometry, own, other)
+                  - xo_mnk_line_score (geometry, other, own);
+  return SDL_max (SDL_min (score, XO_MNK_SCORE_EVAL_MAX),
+                  -XO_MNK_SCORE_EVAL_MAX);
+}
+
+/// M,N,K SEARCH
+
+/*
+ * The CPU on boards other than 3x3, which are too large for the 3x3 engine
+ * and its tables. It is searched like the other variants, through
+ * xo_game_cpu_variant_search: alpha-beta with principal variation search,
+ * the shared transposition table, killer moves and iterative deepening under
+ * the budget, on one thread or with Lazy SMP. Only the cells next to a piece
+ * are tried, threats first, and a threat of the opponent to win leaves the
+ * block as the only move. The leaves are scored with xo_mnk_evaluate. A
+ * threat-space search runs first, for the forced wins too deep for this one.
+ */
+
+static SDL_bool xo_game_cpu_tt_probe (struct xo_cpu *cpu, uint64_t hash,
+                                      struct xo_cpu_tt_entry *entry);
+static void xo_game_cpu_tt_store (struct xo_cpu *cpu, uint64_t hash,
+                                  int32_t score, enum xo_cpu_bound_type bound,
+                                  int16_t move, uint8_t depth);
+#ifndef XO_GEN_TABLE
+static void xo_game_cpu_tt_clear (struct xo_cpu *cpu);
+#endif
+static SDL_bool xo_game_cpu_stopped (struct xo_cpu *cpu);
+static enum xo_tablebase_value_type
+xo_tablebase_probe_mnk (const struct xo_tablebase *tablebase,
+                        const struct xo_mnk_board *board);
+
+/**
+ * Searches a position with alpha-beta. This is the body of every kernel:
+ * geometry is either the runtime one, or a copy whose sizes are constants.
+ * Positions the tablebase holds are answered from it. The moves are tried
+ * from the table move, the killer move of the ply, then by set as listed
+ * below, each set from a cell that depends on the thread for Lazy SMP
+ * helpers.
+ * @param search The position is search->board
+ * @param geometry
+ * @param negamax Kernel the children are searched with
+ * @param side Side to move
+ * @param depth Plies left before the position is evaluated
+ * @param alpha
+ * @param beta
+ * @param ply Plies played since the root
+ * @param hash Zobrist hash of the position
+ * @param move Receives the best move
+ * @return The score for the side to move
+ */
+XO_INLINE int32_t
+xo_mnk_search_node (struct xo_mnk_search *search,
+                    const struct xo_mnk_geometry *geometry,
+                    int32_t (*negamax) (struct xo_mnk_search *search,
+                                        enum xo_bit_meaning_type side,
+                                        uint8_t depth, int32_t alpha,
+                                        int32_t beta, uint16_t ply,
+                                        uint64_t hash, uint16_t *move),
+                    enum xo_bit_meaning_type side, uint8_t depth,
+                    int32_t alpha, int32_t beta, uint16_t ply, uint64_t hash,
+                    uint16_t *move)
+{
+  struct xo_cpu *cpu = search->cpu;
+  uint8_t word_count = geometry->word_count;
+  struct xo_mnk_board *board = &search->board;
+  struct xo_mnk_bits *own
+      = side == XO_BIT_MEANING_SIDE_X ? &board->x : &board->o;
+  const struct xo_mnk_bits *other
+      = side == XO_BIT_MEANING_SIDE_X ? &board->o : &board->x;
+  enum xo_bit_meaning_type other_side = side == XO_BIT_MEANING_SIDE_X
+                                            ? XO_BIT_MEANING_SIDE_O
+                                            : XO_BIT_MEANING_SIDE_X;
+  int32_t empty_count = geometry->cells - board->count;
+  struct xo_mnk_bits occupied;
+  struct xo_mnk_bits empty;
+  struct xo_mnk_bits wins;
+  struct xo_mnk_bits threats;
+
+  cpu->stats.nodes++;
+  if (xo_game_cpu_stopped (cpu))
+    {
+      return 0;
+    }
+
+  for (uint8_t word = 0; word < word_count; word++)
+    {
+      occupied.words[word] = board->x.words[word] | board->o.words[word];
+      empty.words[word] = geometry->full.words[word] & ~occupied.words[word];
+    }
+
+  xo_mnk_completions (geometry, own, &empty, 1, &wins);
+  uint16_t bit = xo_mnk_bits_next (&wins, 0, word_count);
+  if (bit != XO_MNK_BITS)
+    {
+      *move = bit;
+      return XO_MNK_SCORE_WIN + empty_count - 1;
+    }
+  if (empty_count == 0)
+    {
+      return 0;
+    }
+
+  xo_mnk_completions (geometry, other, &empty, 1, &threats);
+  uint16_t threat_count = xo_mnk_bits_count (&threats, word_count);
+  if (threat_count >= 2)
+    {
+      *move = xo_mnk_bits_next (&threats, 0, word_count);
+      return -(XO_MNK_SCORE_WIN + empty_count - 2);
+    }
+  if (search->tablebase != NULL && ply > 0)
+    {
+      enum xo_tablebase_value_type value
+          = xo_tablebase_probe_mnk (search->tablebase, board);
+      if (value == XO_TABLEBASE_WIN)
+        {
+          return XO_MNK_SCORE_WIN;
+        }
+      if (value == XO_TABLEBASE_LOSS)
+        {
+          return -XO_MNK_SCORE_WIN;
+        }
+      if (value == XO_TABLEBASE_DRAW)
+        {
+          return 0;
+        }
+    }
+  if (depth == 0)
+    {
+      return xo_mnk_evaluate (geometry, own, other);
+    }
+
+  uint16_t hash_move = XO_MNK_BITS;
+  struct xo_cpu_tt_entry entry;
+  if (xo_game_cpu_tt_probe (cpu, hash, &entry))
+    {
+      hash_move = (uint16_t)entry.move;
+      if (ply > 0 && entry.depth >= depth
+          && (entry.bound == XO_CPU_BOUND_EXACT
+              || (entry.bound == XO_CPU_BOUND_LOWER && entry.score >= beta)
+              || (entry.bound == XO_CPU_BOUND_UPPER && entry.score <= alpha)))
+        {
+          *move = hash_move;
+          return entry.score;
+        }
+    }
+
+  /* Sets of moves in the order they are tried; a move is only tried from the
+   * first set it is in. With a threat to block, the block is the only move. */
+  const struct xo_mnk_bits *allowed = threat_count == 1 ? &threats : &empty;
+  struct xo_mnk_bits candidates[8] = { 0 };
+  uint8_t candidate_sets = 0;
+  uint16_t firsts[2] = { hash_move, search->killers[ply] };
+  for (uint8_t i = 0; i < 2; i++)
+    {
+      if (firsts[i] < XO_MNK_BITS && xo_mnk_bits_test (allowed, firsts[i]))
+        {
+          xo_mnk_bits_toggle (&candidates[candidate_sets++], firsts[i]);
+        }
+    }
+  if (threat_count == 1)
+    {
+      candidates[candidate_sets++] = threats;
+    }
+  else
+    {
+      /* Own fours, blocks of the opponent's, own threes, blocks of the
+       * opponent's, then the other cells next to a piece, or the center of
+       * an empty board */
+      xo_mnk_completions (geometry, own, &empty, 2,
+                          &candidates[candidate_sets++]);
+      xo_mnk_completions (geometry, other, &empty, 2,
+                          &candidates[candidate_sets++]);
+      if (geometry->k > 2)
+        {
+          xo_mnk_completions (geometry, own, &empty, 3,
+                              &candidates[candidate_sets++]);
+          xo_mnk_completions (geometry, other, &empty, 3,
+                              &candidates[candidate_sets++]);
+        }
+      xo_mnk_neighbours (geometry, &occupied, &candidates[candidate_sets]);
+      if (board->count == 0)
+        {
+          xo_mnk_bits_toggle (
+              &candidates[candidate_sets],
+              xo_mnk_cell_bit (geometry, (geometry->width - 1) / 2,
+                               (geometry->height - 1) / 2));
+        }
+      candidate_sets++;
+    }
+
+  /* Each set is walked from start to its end, then from its beginning */
+  uint16_t start = (uint16_t)(cpu->perturbation * 37u
+                              % (geometry->stride * geometry->height));
+  struct xo_mnk_bits tried = { 0 };
+  int32_t alpha_start = alpha;
+  int32_t best_score = -XO_CPU_SCORE_INFINITY;
+  uint16_t best_move = XO_MNK_BITS;
+  uint16_t searched = 0;
+  for (uint8_t set = 0; set < candidate_sets && alpha < beta; set++)
+    {
+      for (uint8_t pass = 0; pass < 2 && alpha < beta; pass++)
+        {
+          for (bit = xo_mnk_bits_next (&candidates[set], pass == 0 ? start : 0,
+                                       word_count);
+               bit != XO_MNK_BITS && (pass == 0 || bit < start)
+               && alpha < beta;
+               bit = xo_mnk_bits_next (&candidates[set], (uint16_t)(bit + 1),
+                                       word_count))
+            {
+              if (xo_mnk_bits_test (&tried, bit))
+                {
+                  continue;
+                }
+              xo_mnk_bits_toggle (&tried, bit);
+
+              uint64_t child_hash
+                  = hash ^ xo_mnk_zobrist_side
+                    ^ xo_mnk_zobrist[side == XO_BIT_MEANING_SIDE_O][bit];
+              uint16_t reply = XO_MNK_BITS;
+              int32_t score;
+              xo_mnk_bits_toggle (own, bit);
+              board->count++;
+              if (searched > 0 && cpu->config.b_pvs)
+                {
+                  score = -negamax (search, other_side, (uint8_t)(depth - 1),
+                                    -alpha - 1, -alpha, (uint16_t)(ply + 1),
+                                    child_hash, &reply);
+                  if (score > alpha && score < beta)
+                    {
+                      score = -negamax (search, other_side,
+                                        (uint8_t)(depth - 1), -beta, -alpha,
+                                        (uint16_t)(ply + 1), child_hash,
+                                        &reply);
+                    }
+                }
+              else
+                {
+                  score = -negamax (search, other_side, (uint8_t)(depth - 1),
+                                    -beta, -alpha, (uint16_t)(ply + 1),
+                                    child_hash, &reply);
+                }
+              board->count--;
+              xo_mnk_bits_toggle (own, bit);
+              if (xo_game_cpu_stopped (cpu))
+                {
+                  return 0;
+                }
+
+              searched++;
+              if (score > best_score)
+                {
+                  best_score = score;
+                  best_move = bit;
+                }
+              alpha = SDL_max (alpha, score);
+              if (alpha >= beta)
+                {
+                  search->killers[ply] = bit;
+                  cpu->stats.cutoffs++;
+                  cpu->stats.first_move_cutoffs += searched == 1;
+                }
+            }
+        }
+    }
+
+  xo_game_cpu_tt_store (cpu, hash, best_score,
+                        best_score <= alpha_start ? XO_CPU_BOUND_UPPER
+                        : best_score >= beta      ? XO_CPU_BOUND_LOWER
+                                                  : XO_CPU_BOUND_EXACT,
+                        (int16_t)best_move, depth);
+  *move = best_move;
+  return best_score;
+}
+
+/**
+ * Searches a position with alpha-beta, on a board of any size.
+ * @param search The position is search->board
+ * @param side Side to move
+ * @param depth Plies left before the position is evaluated
+ * @param alpha
+ * @param beta
+ * @param ply Plies played since the root
+ * @param hash Zobrist hash of the position
+ * @param move Receives the best move
+ * @return The score for the side to move
+ */
+static int32_t
+xo_mnk_search_negamax (struct xo_mnk_search *search,
+                       enum xo_bit_meaning_type side, uint8_t depth,
+                       int32_t alpha, int32_t beta, uint16_t ply,
+                       uint64_t hash, uint16_t *move)
+{
+  return xo_mnk_search_node (search, search->geometry, xo_mnk_search_negamax,
+                             side, depth, alpha, beta, ply, hash, move);
+}
+
+/**
+ * Tests if a bit set holds k cells in a row, on a board of any size.
+ * @param geometry
+ * @param pieces Cells of one side
+ * @return
+ */
+static SDL_bool
+xo_mnk_search_has_line (const struct xo_mnk_geometry *geometry,
+                        const struct xo_mnk_bits *pieces)
+{
+  return xo_mnk_has_line (geometry, pieces);
+}
+
+/*
+ * Kernels for the common board sizes. Each one searches with a copy of the
+ * geometry whose width, height, k, stride and word count are constants, so
+ * that once xo_mnk_search_node and the bit set functions are inlined, the
+ * loops over the words, the directions and the cells of a line are unrolled,
+ * and the shifts and line masks are computed at build time. The full mask
+ * stays a load, being the same in every node. On boards of several words,
+ * such as 15x15 with k = 5, the work is in the words rather than the loops,
+ * and the --bench timings of a copy were within noise of the generic kernel,
+ * so only the small boards get one.
+ */
+#define XO_MNK_KERNEL_GEOMETRY(geometry, w, h, line)                          \
+  (geometry).width = (w);                                                     \
+  (geometry).height = (h);                                                    \
+  (geometry).k = (line);                                                      \
+  (geometry).stride = (w) + 1;                                                \
+  (geometry).word_count = (((w) + 1) * (h) + 63) / 64;                        \
+  (geometry).cells = (w) * (h)
+
+#define XO_MNK_KERNEL(name, w, h, line)                                       \
+  static int32_t xo_mnk_search_negamax_##name (                               \
+      struct xo_mnk_search *search, enum xo_bit_meaning_type side,            \
+      uint8_t depth, int32_t alpha, int32_t beta, uint16_t ply,               \
+      uint64_t hash, uint16_t *move)                                          \
+  {                                                                           \
+    struct xo_mnk_geometry geometry = *search->geometry;                      \
+    XO_MNK_KERNEL_GEOMETRY (geometry, w, h, line);                            \
+    return xo_mnk_search_node (search, &geometry,                             \
+                               xo_mnk_search_negamax_##name, side, depth,     \
+                               alpha, beta, ply, hash, move);                 \
+  }                                                                           \
+                                                                              \
+  static SDL_bool xo_mnk_search_has_line_##name (                             \
+      const struct xo_mnk_geometry *board_geometry,                           \
+      const struct xo_mnk_bits *pieces)                                       \
+  {                                                                           \
+    struct xo_mnk_geometry geometry = *board_geometry;                        \
+    XO_MNK_KERNEL_GEOMETRY (geometry, w, h, line);                            \
+    return xo_mnk_has_line (&geometry, pieces);                               \
+  }
+
+#define XO_MNK_KERNEL_ENTRY(name, w, h, line)                                 \
+  {                                                                           \
+    #name, w, h, line, xo_mnk_search_has_line_##name,                         \
+        xo_mnk_search_negamax_##name                                          \
+  }
+
+#if XO_MNK_KERNELS
+XO_MNK_KERNEL (3x3k3, 3, 3, 3)
+XO_MNK_KERNEL (4x4k4, 4, 4, 4)
+XO_MNK_KERNEL (5x5k4, 5, 5, 4)
+#endif
+
+/* The generic kernel comes last, and is used for every other size */
+static const struct xo_mnk_kernel xo_mnk_kernels[] = {
+#if XO_MNK_KERNELS
+  XO_MNK_KERNEL_ENTRY (3x3k3, 3, 3, 3),
+  XO_MNK_KERNEL_ENTRY (4x4k4, 4, 4, 4),
+  XO_MNK_KERNEL_ENTRY (5x5k4, 5, 5, 4),
+#endif
+  { "generic", 0, 0, 0, xo_mnk_search_has_line, xo_mnk_search_negamax }
+};
+
+/**
+ * Picks the kernel of a board.
+ * @param geometry
+ * @return The kernel of its size, or the generic kernel
+ */
+static const struct xo_mnk_kernel *
+xo_mnk_kernel_find (const struct xo_mnk_geometry *geometry)
+{
+  const size_t count = sizeof (xo_mnk_kernels) / sizeof (xo_mnk_kernels[0]);
+  for (size_t i = 0; i + 1 < count; i++)
+    {
+      if (xo_mnk_kernels[i].width == geometry->width
+          && xo_mnk_kernels[i].height == geometry->height
+          && xo_mnk_kernels[i].k == geometry->k)
+        {
+          return &xo_mnk_kernels[i];
+        }
+    }
+  return &xo_mnk_kernels[count - 1];
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Fills a board with random positions for the kernel benchmark: pieces
+ * played in turn on random cells near the center, none making a line.
+ * @param geometry
+ * @param kernel Win check of the board
+ * @param state splitmix64 generator state
+ * @param board Receives the position
+ */
+static void
+xo_mnk_kernel_bench_position (const struct xo_mnk_geometry *geometry,
+                              const struct xo_mnk_kernel *kernel,
+                              uint64_t *state, struct xo_mnk_board *board)
+{
+  uint8_t area_width = (uint8_t)SDL_min (geometry->width, 7);
+  uint8_t area_height = (uint8_t)SDL_min (geometry->height, 7);
+  uint16_t pieces = (uint16_t)SDL_min (area_width * area_height / 3, 16);
+
+  *board = (struct xo_mnk_board){ 0 };
+  for (uint16_t tries = 0; board->count < pieces && tries < 1000; tries++)
+    {
+      uint64_t random = xo_util_splitmix64 (state);
+      int col = (geometry->width - area_width) / 2
+                + (int)(random % area_width);
+      int row = (geometry->height - area_height) / 2
+                + (int)(random / area_width % area_height);
+      uint16_t bit = xo_mnk_cell_bit (geometry, col, row);
+      struct xo_mnk_bits *own = board->count % 2 == 0 ? &board->x : &board->o;
+      if (xo_mnk_bits_test (&board->x, bit)
+          || xo_mnk_bits_test (&board->o, bit))
+        {
+          continue;
+        }
+
+      xo_mnk_bits_toggle (own, bit);
+      if (kernel->has_line (geometry, own))
+        {
+          xo_mnk_bits_toggle (own, bit);
+          continue;
+        }
+      board->count++;
+    }
+}
+
+/**
+ * Searches every benchmark position to a fixed depth with a kernel, each from
+ * an empty transposition table.
+ * @param cpu Serial engine to search with
+ * @param geometry
+ * @param kernel
+ * @param positions
+ * @param depth
+ * @param nodes Receives the nodes searched
+ * @param score_sum Receives the sum of the scores, to compare kernels with
+ * @return The time taken, in performance counter ticks
+ */
+static Uint64
+xo_mnk_kernel_bench_search (struct xo_cpu *cpu,
+                            const struct xo_mnk_geometry *geometry,
+                            const struct xo_mnk_kernel *kernel,
+                            const struct xo_mnk_board *positions,
+                            uint8_t depth, uint64_t *nodes,
+                            int64_t *score_sum)
+{
+  Uint64 start = SDL_GetPerformanceCounter ();
+  *nodes = 0;
+  *score_sum = 0;
+  for (int i = 0; i < XO_MNK_BENCH_POSITIONS; i++)
+    {
+      struct xo_mnk_search search;
+      uint16_t move = XO_MNK_BITS;
+      enum xo_bit_meaning_type side = positions[i].count % 2 == 0
+                                          ? XO_BIT_MEANING_SIDE_X
+                                          : XO_BIT_MEANING_SIDE_O;
+      search.cpu = cpu;
+      search.geometry = geometry;
+      search.kernel = kernel;
+      search.tablebase = NULL;
+      search.board = positions[i];
+      memset (search.killers, 0xFF, sizeof (search.killers));
+      cpu->stats = (struct xo_cpu_stats){ 0 };
+      xo_game_cpu_tt_clear (cpu);
+      *score_sum += kernel->negamax (
+          &search, side, depth, -XO_CPU_SCORE_INFINITY, XO_CPU_SCORE_INFINITY,
+          0, xo_mnk_hash (geometry, &positions[i], side), &move);
+      *nodes += cpu->stats.nodes;
+    }
+  return SDL_GetPerformanceCounter () - start;
+}
+
+/**
+ * Times every size-specialized kernel against the generic one, on the same
+ * random positions: the win check, then a search to the depth where the
+ * generic kernel takes XO_MNK_BENCH_NODES nodes. Both must search the same
+ * nodes and find the same scores.
+ * @param cpu Serial engine to search with
+ * @return 0 for success
+ */
+static int32_t
+xo_mnk_kernel_bench (struct xo_cpu *cpu)
+{
+  const size_t count = sizeof (xo_mnk_kernels) / sizeof (xo_mnk_kernels[0]);
+  const struct xo_mnk_kernel *generic_kernel = &xo_mnk_kernels[count - 1];
+  const int repeat = 2000;
+  double frequency = (double)SDL_GetPerformanceFrequency ();
+
+  printf ("\n%-8s %12s %12s %8s %6s %10s %12s %12s %8s\n", "kernel",
+          "line ns", "generic ns", "speedup", "depth", "nodes", "search ms",
+          "generic ms", "speedup");
+  for (size_t i = 0; i + 1 < count; i++)
+    {
+      const struct xo_mnk_kernel *kernel = &xo_mnk_kernels[i];
+      struct xo_mnk_geometry geometry;
+      struct xo_mnk_board positions[XO_MNK_BENCH_POSITIONS];
+      uint64_t state = 0x5eed;
+      xo_mnk_geometry_init (&geometry, kernel->width, kernel->height,
+                            kernel->k);
+      for (int p = 0; p < XO_MNK_BENCH_POSITIONS; p++)
+        {
+          xo_mnk_kernel_bench_position (&geometry, kernel, &state,
+                                        &positions[p]);
+        }
+
+      /* Win checks, through the pointers the callers use */
+      const struct xo_mnk_kernel *checked[2] = { kernel, generic_kernel };
+      Uint64 line_ticks[2];
+      uint32_t lines[2] = { 0 };
+      for (int c = 0; c < 2; c++)
+        {
+          Uint64 start = SDL_GetPerformanceCounter ();
+          for (int r = 0; r < repeat; r++)
+            {
+              for (int p = 0; p < XO_MNK_BENCH_POSITIONS; p++)
+                {
+                  lines[c] += checked[c]->has_line (&geometry,
+                                                    &positions[p].x);
+                  lines[c] += checked[c]->has_line (&geometry,
+                                                    &positions[p].o);
+                }
+            }
+          line_ticks[c] = SDL_GetPerformanceCounter () - start;
+        }
+
+      /* Deepens the search until it takes enough nodes */
+      uint8_t depth = 0;
+      uint64_t nodes[2] = { 0 };
+      int64_t scores[2] = { 0 };
+      Uint64 search_ticks[2] = { 0 };
+      while (nodes[1] < XO_MNK_BENCH_NODES && depth < geometry.cells)
+        {
+          depth++;
+          search_ticks[1] = xo_mnk_kernel_bench_search (
+              cpu, &geometry, generic_kernel, positions, depth, &nodes[1],
+              &scores[1]);
+        }
+      search_ticks[0] = xo_mnk_kernel_bench_search (
+          cpu, &geometry, kernel, positions, depth, &nodes[0], &scores[0]);
+
+      if (lines[0] != lines[1] || nodes[0] != nodes[1]
+          || scores[0] != scores[1])
+        {
+          xo_log_error (SDL_FALSE,
+                        "Kernel %s disagrees with the generic kernel\n",
+                        kernel->name);
+          return 1;
+        }
+
+      double calls = 2.0 * repeat * XO_MNK_BENCH_POSITIONS;
+      double line_ns[2], search_ms[2];
+      for (int c = 0; c < 2; c++)
+        {
+          line_ns[c] = (double)line_ticks[c] * 1e9 / frequency / calls;
+          search_ms[c] = (double)search_ticks[c] * 1000.0 / frequency;
+        }
+      printf ("%-8s %12.2f %12.2f %8.2f %6u %10" SDL_PRIu64
+              " %12.3f %12.3f %8.2f\n",
+              kernel->name, line_ns[0], line_ns[1],
+              line_ns[0] > 0.0 ? line_ns[1] / line_ns[0] : 0.0, depth,
+              nodes[0], search_ms[0], search_ms[1],
+              search_ms[0] > 0.0 ? search_ms[1] / search_ms[0] : 0.0);
+    }
+  return 0;
+}
+#endif
+
+/// QUBIC BOARDS
+
+/*
+ * Qubic is 4 in a row in a 4x4x4 cube, along any of 76 lines: the rows,
+ * columns and diagonals of every layer, the verticals and the diagonals across
+ * the layers, and the 4 diagonals of the cube. With one bit per cell, each
+ * line is a mask of 4 bits. On screen, the 4 layers are shown side by side as
+ * the squares of an 8x8 board, two layers per row.
+ */
+
+static uint64_t xo_qubic_lines[XO_QUBIC_LINES];
+static uint8_t xo_qubic_cell_lines[XO_QUBIC_CELLS][XO_QUBIC_CELL_LINES];
+static uint8_t xo_qubic_cell_line_counts[XO_QUBIC_CELLS];
+static uint8_t xo_qubic_order[XO_QUBIC_CELLS]; /* Cells in most lines first */
+static uint64_t xo_qubic_zobrist[2][XO_QUBIC_CELLS];
+static uint64_t xo_qubic_zobrist_side;
+
+/**
+ * Fills the line masks of the cube, the lines through each cell, the static
+ * move order and the Zobrist keys. Every line is found once from each end,
+ * and kept once.
+ */
+static void
+xo_qubic_init (void)
+{
+  uint8_t line_count = 0;
+  memset (xo_qubic_cell_line_counts, 0, sizeof (xo_qubic_cell_line_counts));
+
+  for (int start = 0; start < XO_QUBIC_CELLS; start++)
+    {
+      for (int direction = 0; direction < 27; direction++)
+        {
+          int dx = direction % 3 - 1;
+          int dy = direction / 3 % 3 - 1;
+          int dz = direction / 9 - 1;
+          int x = start % XO_QUBIC_SIZE + dx * (XO_QUBIC_SIZE - 1);
+          int y = start / XO_QUBIC_SIZE % XO_QUBIC_SIZE
+                  + dy * (XO_QUBIC_SIZE - 1);
+          int z = start / (XO_QUBIC_SIZE * XO_QUBIC_SIZE)
+                  + dz * (XO_QUBIC_SIZE - 1);
+          if ((dx == 0 && dy == 0 && dz == 0) || x < 0
+              || x >= XO_QUBIC_SIZE || y < 0 || y >= XO_QUBIC_SIZE || z < 0
+              || z >= XO_QUBIC_SIZE)
+            {
+              continue;
+            }
+
+          uint64_t line = 0;
+          for (int i = 0; i < XO_QUBIC_SIZE; i++)
+            {
+              line |= 1ull << (start
+                               + i * (dx + dy * XO_QUBIC_SIZE
+                                      + dz * XO_QUBIC_SIZE * XO_QUBIC_SIZE));
+            }
+          uint8_t known = 0;
+          while (known < line_count && xo_qubic_lines[known] != line)
+            {
+              known++;
+            }
+          if (known < line_count || line_count == XO_QUBIC_LINES)
+            {
+              continue;
+            }
+
+          xo_qubic_lines[line_count] = line;
+          for (uint8_t cell = 0; cell < XO_QUBIC_CELLS; cell++)
+            {
+              if ((line >> cell & 1) != 0)
+                {
+                  xo_qubic_cell_lines[cell][xo_qubic_cell_line_counts[cell]++]
+                      = line_count;
+                }
+            }
+          line_count++;
+        }
+    }
+
+  /* The 8 corners and the 8 center cells are on 7 lines, the others on 4 */
+  uint8_t ordered = 0;
+  for (uint8_t lines = XO_QUBIC_CELL_LINES; lines > 0; lines--)
+    {
+      for (uint8_t cell = 0; cell < XO_QUBIC_CELLS; cell++)
+        {
+          if (xo_qubic_cell_line_counts[cell] == lines)
+            {
+              xo_qubic_order[ordered++] = cell;
+            }
+        }
+    }
+
+  uint64_t seed = 0x5155424943ull;
+  for (uint8_t side = 0; side < 2; side++)
+    {
+      for (uint8_t cell = 0; cell < XO_QUBIC_CELLS; cell++)
+        {
+          xo_qubic_zobrist[side][cell] = xo_util_splitmix64 (&seed);
+        }
+    }
+  xo_qubic_zobrist_side = xo_util_splitmix64 (&seed);
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Finds the cells where a side completes a line: the empty cell of every line
+ * where it has the 3 others. A line holds 3 pieces of the side when clearing
+ * its two lowest leaves a bit.
+ * @param own Pieces of the side
+ * @param other Pieces of the other side
+ * @return
+ */
+static uint64_t
+xo_qubic_completions (uint64_t own, uint64_t other)
+{
+  uint64_t cells = 0;
+  for (uint8_t line = 0; line < XO_QUBIC_LINES; line++)
+    {
+      uint64_t mask = xo_qubic_lines[line];
+      uint64_t mine = own & mask;
+      mine &= mine - 1;
+      mine &= mine - 1;
+      if (mine != 0 && (other & mask) == 0)
+        {
+          cells |= mask & ~own;
+        }
+    }
+  return cells;
+}
+
+/**
+ * Finds the lowest cell of a set.
+ * @param cells A set with at least one cell
+ * @return
+ */
+static uint8_t
+xo_qubic_first_cell (uint64_t cells)
+{
+  uint8_t cell = 0;
+  for (; (cells & 1) == 0; cells >>= 1)
+    {
+      cell++;
+    }
+  return cell;
+}
+
+/**
+ * Tests if a side has 4 in a row.
+ * @param pieces Pieces of the side
+ * @return
+ */
+static SDL_bool
+xo_qubic_has_line (uint64_t pieces)
+{
+  for (uint8_t line = 0; line < XO_QUBIC_LINES; line++)
+    {
+      if ((pieces & xo_qubic_lines[line]) == xo_qubic_lines[line])
+        {
+          return SDL_TRUE;
+        }
+    }
+  return SDL_FALSE;
+}
+
+/**
+ * Returns the state of a Qubic game.
+ * @param board
+ * @return
+ */
+static enum xo_win_state_type
+xo_qubic_final_state (const struct xo_qubic_board *board)
+{
+  if (xo_qubic_has_line (board->x))
+    {
+      return XO_WIN_STATE_X_WIN;
+    }
+  if (xo_qubic_has_line (board->o))
+    {
+      return XO_WIN_STATE_O_WIN;
+    }
+  if (board->count == XO_QUBIC_CELLS)
+    {
+      return XO_WIN_STATE_TIE;
+    }
+  return XO_WIN_STATE_NONE;
+}
+
+/**
+ * Finds the square of a cell on the 8x8 board the cube is shown on.
+ * @param cell
+ * @return
+ */
+static SDL_Point
+xo_qubic_cell_square (uint8_t cell)
+{
+  uint8_t layer = cell / (XO_QUBIC_SIZE * XO_QUBIC_SIZE);
+  return (SDL_Point){ layer % 2 * XO_QUBIC_SIZE + cell % XO_QUBIC_SIZE,
+                      layer / 2 * XO_QUBIC_SIZE
+                          + cell / XO_QUBIC_SIZE % XO_QUBIC_SIZE };
+}
+
+/**
+ * Reads a Qubic position from the 8x8 board it is shown on.
+ * @param geometry The 8x8 board
+ * @param pieces
+ * @param board Receives the position
+ */
+static void
+xo_qubic_from_mnk (const struct xo_mnk_geometry *geometry,
+                   const struct xo_mnk_board *pieces,
+                   struct xo_qubic_board *board)
+{
+  *board = (struct xo_qubic_board){ 0 };
+  for (uint8_t cell = 0; cell < XO_QUBIC_CELLS; cell++)
+    {
+      SDL_Point square = xo_qubic_cell_square (cell);
+      uint16_t bit = xo_mnk_cell_bit (geometry, square.x, square.y);
+      if (xo_mnk_bits_test (&pieces->x, bit))
+        {
+          board->x |= 1ull << cell;
+          board->count++;
+        }
+      else if (xo_mnk_bits_test (&pieces->o, bit))
+        {
+          board->o |= 1ull << cell;
+          board->count++;
+        }
+    }
+}
+
+/**
+ * Computes the Zobrist hash of a Qubic position from scratch.
+ * @param board
+ * @param side Side to move
+ * @return
+ */
+static uint64_t
+xo_qubic_hash (const struct xo_qubic_board *board,
+               enum xo_bit_meaning_type side)
+{
+  uint64_t hash = side == XO_BIT_MEANING_SIDE_X ? xo_qubic_zobrist_side : 0;
+  for (uint8_t cell = 0; cell < XO_QUBIC_CELLS; cell++)
+    {
+      if ((board->x >> cell & 1) != 0)
+        {
+          hash ^= xo_qubic_zobrist[0][cell];
+        }
+      else if ((board->o >> cell & 1) != 0)
+        {
+          hash ^= xo_qubic_zobrist[1][cell];
+        }
+    }
+  return hash;
+}
+
+/**
+ * Scores a Qubic position for a side by the lines still open to each side:
+ * a line with n pieces of one side and none of the other is worth 6^(n - 1)
+ * to that side.
+ * @param own Pieces of the side
+ * @param other Pieces of the other side
+ * @return
+ */
+static int32_t
+xo_qubic_evaluate (uint64_t own, uint64_t other)
+{
+  static const int32_t weights[XO_QUBIC_SIZE + 1] = { 0, 1, 6, 36, 216 };
+  int32_t score = 0;
+  for (uint8_t line = 0; line < XO_QUBIC_LINES; line++)
+    {
+      uint64_t mask = xo_qubic_lines[line];
+      uint64_t mine = own & mask;
+      uint64_t theirs = other & mask;
+      uint8_t count = 0;
+      if (theirs == 0)
+        {
+          for (; mine != 0; mine &= mine - 1)
+            {
+              count++;
+            }
+          score += weights[count];
+        }
+      else if (mine == 0)
+        {
+          for (; theirs != 0; theirs &= theirs - 1)
+            {
+              count++;
+            }
+          score -= weights[count];
+        }
+    }
+  return score;
+}
+#endif
+
+/// ULTIMATE TIC-TAC-TOE
+
+/*
+ * Ultimate tic-tac-toe is played on 9 local 3x3 boards, laid out as a 3x3
+ * board of boards. The square a side plays on picks the local board the
+ * other side must play in next, unless that board is already won or full,
+ * in which case any open local board will do. Winning a local board claims
+ * its square of the global board, and three local boards in a row win the
+ * game. Each local board is an xo_board_data, and so is the global board, so
+ * that xo_board_make_move tells at once when a move wins either.
+ */
+
+/* For each 9-bit set of a side's pieces, the squares where one more piece
+ * completes a line */
+static uint16_t xo_ultimate_completions[1 << XO_BOARD_SQUARES];
+static uint64_t xo_ultimate_zobrist[2][XO_ULTIMATE_CELLS];
+static uint64_t xo_ultimate_zobrist_next[XO_BOARD_SQUARES + 1];
+static uint64_t xo_ultimate_zobrist_side;
+
+/**
+ * Fills the completion table and the Zobrist keys.
+ */
+static void
+xo_ultimate_init (void)
+{
+  for (uint16_t pieces = 0; pieces < (1 << XO_BOARD_SQUARES); pieces++)
+    {
+      xo_ultimate_completions[pieces] = 0;
+      for (uint8_t square = 0; square < XO_BOARD_SQUARES; square++)
+        {
+          uint16_t after = (uint16_t)(pieces | 1u << square);
+          for (uint8_t line = 0; line < XO_BOARD_LINE_COUNT; line++)
+            {
+              if ((pieces >> square & 1) == 0
+                  && (after & xo_board_win_masks[line])
+                         == xo_board_win_masks[line])
+                {
+                  xo_ultimate_completions[pieces] |= (uint16_t)(1u << square);
+                }
+            }
+        }
+    }
+
+  uint64_t seed = 0x554C54494D41ull;
+  for (uint8_t side = 0; side < 2; side++)
+    {
+      for (uint8_t cell = 0; cell < XO_ULTIMATE_CELLS; cell++)
+        {
+          xo_ultimate_zobrist[side][cell] = xo_util_splitmix64 (&seed);
+        }
+    }
+  for (uint8_t next = 0; next <= XO_BOARD_SQUARES; next++)
+    {
+      xo_ultimate_zobrist_next[next] = xo_util_splitmix64 (&seed);
+    }
+  xo_ultimate_zobrist_side = xo_util_splitmix64 (&seed);
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Finds the lowest square of a set.
+ * @param squares A set with at least one square
+ * @return
+ */
+static uint8_t
+xo_ultimate_first_square (uint16_t squares)
+{
+  uint8_t square = 0;
+  for (; (squares & 1) == 0; squares >>= 1)
+    {
+      square++;
+    }
+  return square;
+}
+
+/**
+ * Finds the local boards the side to move may play in.
+ * @param board
+ * @return
+ */
+static uint16_t
+xo_ultimate_open_boards (const struct xo_ultimate_board *board)
+{
+  if (board->next != XO_CPU_NO_MOVE)
+    {
+      return (uint16_t)(1u << board->next);
+    }
+  return (uint16_t)(~board->closed & XO_BOARD_FULL_MASK);
+}
+
+/**
+ * Plays a legal move, in place.
+ * @param board
+ * @param side
+ * @param move Local board * 9 + square
+ * @return SDL_TRUE if the move wins the game
+ */
+static SDL_bool
+xo_ultimate_play (struct xo_ultimate_board *board,
+                  enum xo_bit_meaning_type side, uint8_t move)
+{
+  uint8_t local = move / XO_BOARD_SQUARES;
+  uint8_t square = move % XO_BOARD_SQUARES;
+  SDL_bool b_won = SDL_FALSE;
+
+  board->count++;
+  if (xo_board_make_move (&board->locals[local], side, square))
+    {
+      board->closed |= (uint16_t)(1u << local);
+      b_won = xo_board_make_move (&board->global, side, local);
+    }
+  else if (xo_board_check_if_full (&board->locals[local]))
+    {
+      board->closed |= (uint16_t)(1u << local);
+    }
+  board->next = (board->closed >> square & 1) != 0 ? XO_CPU_NO_MOVE
+                                                    : (int8_t)square;
+  return b_won;
+}
+
+/**
+ * Returns the state of an ultimate tic-tac-toe game. When every local board
+ * is closed and no one has three in a row, the game is a tie.
+ * @param board
+ * @return
+ */
+static enum xo_win_state_type
+xo_ultimate_final_state (const struct xo_ultimate_board *board)
+{
+  struct xo_board_data global = board->global;
+  if (xo_board_validate_win_conditions_for (&global, XO_BIT_MEANING_SIDE_X))
+    {
+      return XO_WIN_STATE_X_WIN;
+    }
+  if (xo_board_validate_win_conditions_for (&global, XO_BIT_MEANING_SIDE_O))
+    {
+      return XO_WIN_STATE_O_WIN;
+    }
+  if (board->closed == XO_BOARD_FULL_MASK)
+    {
+      return XO_WIN_STATE_TIE;
+    }
+  return XO_WIN_STATE_NONE;
+}
+
+/**
+ * Finds the square of a move on the 9x9 board.
+ * @param move
+ * @return
+ */
+static SDL_Point
+xo_ultimate_move_square (uint8_t move)
+{
+  uint8_t local = move / XO_BOARD_SQUARES;
+  uint8_t square = move % XO_BOARD_SQUARES;
+  return (SDL_Point){
+    local % XO_BOARD_SIZE * XO_BOARD_SIZE + square % XO_BOARD_SIZE,
+    local / XO_BOARD_SIZE * XO_BOARD_SIZE + square / XO_BOARD_SIZE
+  };
+}
+
+/**
+ * Finds the move of a square of the 9x9 board.
+ * @param col
+ * @param row
+ * @return
+ */
+static uint8_t
+xo_ultimate_square_move (int col, int row)
+{
+  int local = row / XO_BOARD_SIZE * XO_BOARD_SIZE + col / XO_BOARD_SIZE;
+  int square = row % XO_BOARD_SIZE * XO_BOARD_SIZE + col % XO_BOARD_SIZE;
+  return (uint8_t)(local * XO_BOARD_SQUARES + square);
+}
+
+/**
+ * Reads an ultimate tic-tac-toe position from the 9x9 board it is shown on.
+ * The local boards won and closed follow from the pieces, as no one plays in
+ * a board once it is won; the board to play in follows from the last move.
+ * @param geometry The 9x9 board
+ * @param pieces
+ * @param last_move Square of the last move, unused on an empty board
+ * @param board Receives the position
+ */
+static void
+xo_ultimate_from_mnk (const struct xo_mnk_geometry *geometry,
+                      const struct xo_mnk_board *pieces, SDL_Point last_move,
+                      struct xo_ultimate_board *board)
+{
+  *board = (struct xo_ultimate_board){ 0 };
+  for (uint8_t move = 0; move < XO_ULTIMATE_CELLS; move++)
+    {
+      SDL_Point square = xo_ultimate_move_square (move);
+      uint16_t bit = xo_mnk_cell_bit (geometry, square.x, square.y);
+      struct xo_board_data *local = &board->locals[move / XO_BOARD_SQUARES];
+      if (xo_mnk_bits_test (&pieces->x, bit))
+        {
+          xo_board_make_move (local, XO_BIT_MEANING_SIDE_X,
+                              move % XO_BOARD_SQUARES);
+          board->count++;
+        }
+      else if (xo_mnk_bits_test (&pieces->o, bit))
+        {
+          xo_board_make_move (local, XO_BIT_MEANING_SIDE_O,
+                              move % XO_BOARD_SQUARES);
+          board->count++;
+        }
+    }
+
+  for (uint8_t local = 0; local < XO_BOARD_SQUARES; local++)
+    {
+      static const enum xo_bit_meaning_type sides[]
+          = { XO_BIT_MEANING_SIDE_X, XO_BIT_MEANING_SIDE_O };
+      struct xo_board_data *data = &board->locals[local];
+      for (int i = 0; i < 2; i++)
+        {
+          if (xo_board_validate_win_conditions_for (data, sides[i]))
+            {
+              xo_board_make_move (&board->global, sides[i], local);
+              board->closed |= (uint16_t)(1u << local);
+            }
+        }
+      if (xo_board_check_if_full (data))
+        {
+          board->closed |= (uint16_t)(1u << local);
+        }
+    }
+
+  board->next = XO_CPU_NO_MOVE;
+  if (board->count > 0)
+    {
+      uint8_t square = xo_ultimate_square_move (last_move.x, last_move.y)
+                       % XO_BOARD_SQUARES;
+      if ((board->closed >> square & 1) == 0)
+        {
+          board->next = (int8_t)square;
+        }
+    }
+}
+
+/**
+ * Computes the Zobrist hash of an ultimate tic-tac-toe position from
+ * scratch. The local board to play in is part of the position.
+ * @param board
+ * @param side Side to move
+ * @return
+ */
+static uint64_t
+xo_ultimate_hash (const struct xo_ultimate_board *board,
+                  enum xo_bit_meaning_type side)
+{
+  uint64_t hash = xo_ultimate_zobrist_next[board->next + 1];
+  if (side == XO_BIT_MEANING_SIDE_X)
+    {
+      hash ^= xo_ultimate_zobrist_side;
+    }
+  for (uint8_t move = 0; move < XO_ULTIMATE_CELLS; move++)
+    {
+      const struct xo_board_data *local
+          = &board->locals[move / XO_BOARD_SQUARES];
+      if ((local->x >> move % XO_BOARD_SQUARES & 1) != 0)
+        {
+          hash ^= xo_ultimate_zobrist[0][move];
+        }
+      else if ((local->o >> move % XO_BOARD_SQUARES & 1) != 0)
+        {
+          hash ^= xo_ultimate_zobrist[1][move];
+        }
+    }
+  return hash;
+}
+
+/**
+ * Scores the prospects of one side: the local boards it won, the open local
+ * boards that would complete one of its global lines, and its threats and
+ * centers in the open local boards.
+ * @param board
+ * @param side
+ * @return
+ */
+static int32_t
+xo_ultimate_side_score (const struct xo_ultimate_board *board,
+                        enum xo_bit_meaning_type side)
+{
+  uint16_t won
+      = side == XO_BIT_MEANING_SIDE_X ? board->global.x : board->global.o;
+  int32_t score
+      = 24 * xo_util_bit_count (won)
+        + 60
+              * xo_util_bit_count ((uint16_t)(xo_ultimate_completions[won]
+                                              & ~board->closed));
+
+  for (uint8_t local = 0; local < XO_BOARD_SQUARES; local++)
+    {
+      const struct xo_board_data *data = &board->locals[local];
+      uint16_t own = side == XO_BIT_MEANING_SIDE_X ? data->x : data->o;
+      if ((board->closed >> local & 1) != 0)
+        {
+          continue;
+        }
+      score += 4
+               * xo_util_bit_count ((uint16_t)(xo_ultimate_completions[own]
+                                               & ~(data->x | data->o)));
+      score += (own & 0x010) != 0 ? 2 : 0;
+    }
+  return score;
+}
+
+/**
+ * Scores an ultimate tic-tac-toe position for the side to move.
+ * @param board
+ * @param side
+ * @return
+ */
+static int32_t
+xo_ultimate_evaluate (const struct xo_ultimate_board *board,
+                      enum xo_bit_meaning_type side)
+{
+  return xo_ultimate_side_score (board, side)
+         - xo_ultimate_side_score (board, side == XO_BIT_MEANING_SIDE_X
+                                              ? XO_BIT_MEANING_SIDE_O
+                                              : XO_BIT_MEANING_SIDE_X);
+}
+#endif
+
+/// GRAVITY BOARDS
+
+/*
+ * The gravity variant plays K in a row on an m,n,k board, but a piece falls
+ * to the lowest empty cell of its column, as in Connect Four. The cells a
+ * piece can land on are kept in a bit set with one bit per column that is
+ * not full, so the moves are read from it rather than from a scan of the
+ * empty cells, and there are at most width of them. A move toggles its cell
+ * in the pieces and in heights, and the cell above it in heights, so playing
+ * the same move again takes it back.
+ */
+
+#ifndef XO_GEN_TABLE
+/**
+ * Finds the row a piece dropped in a column lands on.
+ * @param geometry
+ * @param pieces
+ * @param col
+ * @return The row, or -1 if the column is full
+ */
+static int
+xo_gravity_drop_row (const struct xo_mnk_geometry *geometry,
+                     const struct xo_mnk_board *pieces, int col)
+{
+  for (int row = geometry->height - 1; row >= 0; row--)
+    {
+      uint16_t bit = xo_mnk_cell_bit (geometry, col, row);
+      if (!xo_mnk_bits_test (&pieces->x, bit)
+          && !xo_mnk_bits_test (&pieces->o, bit))
+        {
+          return row;
+        }
+    }
+  return -1;
+}
+
+/**
+ * Reads a gravity position from an m,n,k board.
+ * @param geometry
+ * @param pieces Pieces, each of which lies on the bottom row or on a piece
+ * @param board Receives the position
+ */
+static void
+xo_gravity_from_mnk (const struct xo_mnk_geometry *geometry,
+                     const struct xo_mnk_board *pieces,
+                     struct xo_gravity_board *board)
+{
+  board->geometry = geometry;
+  board->pieces = *pieces;
+  board->heights = (struct xo_mnk_bits){ 0 };
+  for (int col = 0; col < geometry->width; col++)
+    {
+      int row = xo_gravity_drop_row (geometry, pieces, col);
+      if (row >= 0)
+        {
+          xo_mnk_bits_toggle (&board->heights,
+                              xo_mnk_cell_bit (geometry, col, row));
+        }
+    }
+}
+#endif
+
+/**
+ * Plays a move, or takes it back, without changing the piece count.
+ * @param board
+ * @param side
+ * @param bit Landing cell of the column, from board->heights
+ */
+XO_INLINE void
+xo_gravity_toggle (struct xo_gravity_board *board,
+                   enum xo_bit_meaning_type side, uint16_t bit)
+{
+  uint8_t stride = board->geometry->stride;
+  xo_mnk_bits_toggle (side == XO_BIT_MEANING_SIDE_X ? &board->pieces.x
+                                                    : &board->pieces.o,
+                      bit);
+  xo_mnk_bits_toggle (&board->heights, bit);
+  if (bit >= stride)
+    {
+      xo_mnk_bits_toggle (&board->heights, (uint16_t)(bit - stride));
+    }
+}
+
+/// GAME FUNCTIONS
+
+#ifndef XO_GEN_TABLE
+/**
+ * Renders the board by reading the pieces in game->board (of app param).
+ * Boards other than 3x3 have no grid in their image, so lines are drawn
+ * between the squares.
+ * @param app
+ */
+static void
+xo_board_render (struct xo_app *app)
+{
+  const struct xo_mnk_geometry *geometry = &app->game->geometry;
+  const struct xo_mnk_board *pieces = &app->game->board->pieces;
+  /* Pieces take 4 tiles on the 3x3 board, and shrink as the board grows */
+  int size = XO_TILE_SIZE * 4 * XO_BOARD_SIZE
+             / SDL_max (geometry->width, geometry->height);
+
+  if (!xo_mnk_is_tic_tac_toe (geometry))
+    {
+      SDL_Point window = xo_util_window_size (geometry);
+      SDL_SetRenderDrawColor (app->renderer, 40, 40, 40, 255);
+      for (int col = 1; col < geometry->width; col++)
+        {
+          int x = col * window.x / geometry->width;
+          SDL_RenderDrawLine (app->renderer, x, 0, x, window.y);
+        }
+      for (int row = 1; row < geometry->height; row++)
+        {
+          int y = row * window.y / geometry->height;
+          SDL_RenderDrawLine (app->renderer, 0, y, window.x, y);
+        }
+
+      /* The layers of the Qubic cube are set apart by wider lines */
+      if (app->game->variant == XO_VARIANT_QUBIC)
+        {
+          SDL_SetRenderDrawColor (app->renderer, 160, 160, 160, 255);
+          SDL_RenderFillRect (app->renderer,
+                              &(SDL_Rect){ window.x / 2 - 1, 0, 3, window.y });
+          SDL_RenderFillRect (app->renderer,
+                              &(SDL_Rect){ 0, window.y / 2 - 1, window.x, 3 });
+        }
+
+      /* So are the local boards of ultimate tic-tac-toe, and the one to
+       * play in is outlined */
+      if (app->game->variant == XO_VARIANT_ULTIMATE)
+        {
+          struct xo_ultimate_board board;
+          xo_ultimate_from_mnk (geometry, pieces, app->game->last_move,
+                                &board);
+          SDL_SetRenderDrawColor (app->renderer, 160, 160, 160, 255);
+          for (int i = 1; i < XO_BOARD_SIZE; i++)
+            {
+              SDL_RenderFillRect (
+                  app->renderer,
+                  &(SDL_Rect){ i * window.x / XO_BOARD_SIZE - 1, 0, 3,
+                               window.y });
+              SDL_RenderFillRect (
+                  app->renderer,
+                  &(SDL_Rect){ 0, i * window.y / XO_BOARD_SIZE - 1,
+                               window.x, 3 });
+            }
+          if (board.next != XO_CPU_NO_MOVE)
+            {
+              SDL_SetRenderDrawColor (app->renderer, 220, 180, 60, 255);
+              SDL_RenderDrawRect (
+                  app->renderer,
+                  &(SDL_Rect){
+                      board.next % XO_BOARD_SIZE * window.x / XO_BOARD_SIZE,
+                      board.next / XO_BOARD_SIZE * window.y / XO_BOARD_SIZE,
+                      window.x / XO_BOARD_SIZE, window.y / XO_BOARD_SIZE });
+            }
+        }
+    }
+
+  for (int col = 0; col < geometry->width; col++)
+    {
+      for (int row = 0; row < geometry->height; row++)
+        {
+
+          SDL_Rect dest = (SDL_Rect){ .w = size,
+                                      .h = size,
+                                      .x = (col * size) - XO_BORDER / 2,
+                                      .y = (row * size) - XO_BORDER };
+
+          // Draw the board square at (x, y)
+          uint16_t bit = xo_mnk_cell_bit (geometry, col, row);
+          if (xo_mnk_bits_test (&pieces->x, bit))
+            {
+              SDL_RenderCopy (app->renderer, app->game->Xs, NULL, &dest);
+            }
+          else if (xo_mnk_bits_test (&pieces->o, bit))
+            {
+              SDL_RenderCopy (app->renderer, app->game->Os, NULL, &dest);
+            }
+        }
+    }
+}
+#endif
+
+/**
+ * Returns an enum indicating the current win_state of the provided board. Can
+ * be used to decide if the real game is over OR during AI prediction.
+ * @param board_data
+ * @return
+ */
+static enum xo_win_state_type
 xo_board_test_if_final_state (struct xo_board_data *board_data)
 {
-  if (xo_board_validate_win_conditions_for (board_data, XO_BIT_MEANING_SIDE_X)
-      == SDL_TRUE)
+  if (xo_board_validate_win_conditions_for (board_data, XO_BIT_MEANING_SIDE_X)
+      == SDL_TRUE)
+    {
+      return XO_WIN_STATE_X_WIN;
+    }
+  if (xo_board_validate_win_conditions_for (board_data, XO_BIT_MEANING_SIDE_O)
+      == SDL_TRUE)
+    {
+      return XO_WIN_STATE_O_WIN;
+    }
+  if (xo_board_check_if_full (board_data) == SDL_TRUE)
+    {
+      return XO_WIN_STATE_TIE;
+    }
+
+  return XO_WIN_STATE_NONE;
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Returns the state of the game played, under the rules of its variant.
+ * @param app
+ * @return
+ */
+static enum xo_win_state_type
+xo_game_final_state (struct xo_app *app)
+{
+  if (app->game->variant == XO_VARIANT_QUBIC)
+    {
+      struct xo_qubic_board board;
+      xo_qubic_from_mnk (&app->game->geometry, &app->game->board->pieces,
+                         &board);
+      return xo_qubic_final_state (&board);
+    }
+  if (app->game->variant == XO_VARIANT_ULTIMATE)
+    {
+      struct xo_ultimate_board board;
+      xo_ultimate_from_mnk (&app->game->geometry, &app->game->board->pieces,
+                            app->game->last_move, &board);
+      return xo_ultimate_final_state (&board);
+    }
+  return xo_mnk_board_final_state (&app->game->geometry,
+                                   &app->game->board->pieces);
+}
+
+/**
+ * Tells whether the rules of the variant allow a move on an empty square. In
+ * ultimate tic-tac-toe, the last move picks the local board to play in.
+ * @param app
+ * @param col
+ * @param row
+ * @return
+ */
+static SDL_bool
+xo_game_allows (struct xo_app *app, int col, int row)
+{
+  if (app->game->variant == XO_VARIANT_ULTIMATE)
+    {
+      struct xo_ultimate_board board;
+      xo_ultimate_from_mnk (&app->game->geometry, &app->game->board->pieces,
+                            app->game->last_move, &board);
+      uint8_t local = xo_ultimate_square_move (col, row) / XO_BOARD_SQUARES;
+      return (xo_ultimate_open_boards (&board) >> local & 1) != 0;
+    }
+  return SDL_TRUE;
+}
+
+/**
+ * Play a move at the specified square coordinates for the specified side. A
+ * check is made to ensure the square is empty, since the human-controlled
+ * player can click a non-valid square. In the gravity variant, the piece
+ * drops to the lowest empty square of the column.
+ * @param app
+ * @param side
+ * @param col
+ * @param row
+ * @return
+ */
+static SDL_bool
+xo_game_play (struct xo_app *app, enum xo_bit_meaning_type side, int col,
+              int row)
+{
+  const struct xo_mnk_geometry *geometry = &app->game->geometry;
+  struct xo_mnk_board *pieces = &app->game->board->pieces;
+  if (app->game->variant == XO_VARIANT_GRAVITY && col >= 0
+      && col < geometry->width)
+    {
+      row = xo_gravity_drop_row (geometry, pieces, col);
+    }
+  uint16_t bit = xo_mnk_cell_bit (geometry, col, row);
+  if (col >= 0 && col < geometry->width && row >= 0 && row < geometry->height
+      && !xo_mnk_bits_test (&pieces->x, bit)
+      && !xo_mnk_bits_test (&pieces->o, bit) && xo_game_allows (app, col, row))
+    {
+      xo_log_debug (1, SDL_FALSE, "Playing!");
+      xo_mnk_bits_toggle (side == XO_BIT_MEANING_SIDE_X ? &pieces->x
+                                                        : &pieces->o,
+                          bit);
+      pieces->count++;
+      app->game->last_move = (SDL_Point){ col, row };
+      return SDL_TRUE;
+    }
+  else
+    {
+      xo_log_debug (1, SDL_FALSE, "Tile is occupied. Click ignored...");
+      return SDL_FALSE;
+    }
+}
+#endif
+
+/// TABLEBASES
+
+/*
+ * A tablebase holds the value of every legal position of an m,n,k board, or
+ * of every position with at least min_pieces pieces. It is built by
+ * retrograde analysis: the positions are split into layers by piece count,
+ * and the layers are solved from the full board back to the empty one, so
+ * that every position is solved from the values of the layer after it. The
+ * positions of a layer are independent of each other, so each layer is shared
+ * out among threads 64 positions at a time, one word of its bit planes each.
+ *
+ * X moves first, so a layer of n pieces holds the positions with (n + 1) / 2
+ * X and n / 2 O. Its positions are numbered by xo_tablebase_rank: the rank of
+ * the set of occupied cells among the cells, times the number of ways to
+ * colour them, plus the rank of the set of X among the occupied cells. Sets
+ * are ranked in the combinatorial number system, so the ranks of a layer are
+ * dense, from 0 to the layer size.
+ */
+
+/* Binomial coefficients, up to XO_TABLEBASE_MAX_CELLS. */
+static uint64_t xo_tablebase_binomials[XO_TABLEBASE_MAX_CELLS + 1]
+                                      [XO_TABLEBASE_MAX_CELLS + 1];
+
+/**
+ * Fills xo_tablebase_binomials. Coefficients that do not fit 64 bits are
+ * stored as UINT64_MAX.
+ */
+static void
+xo_tablebase_init_binomials (void)
+{
+  for (uint8_t n = 0; n <= XO_TABLEBASE_MAX_CELLS; n++)
+    {
+      xo_tablebase_binomials[n][0] = 1;
+      for (uint8_t k = 1; k <= n; k++)
+        {
+          uint64_t a = xo_tablebase_binomials[n - 1][k - 1];
+          uint64_t b = k < n ? xo_tablebase_binomials[n - 1][k] : 0;
+          xo_tablebase_binomials[n][k]
+              = a > UINT64_MAX - b ? UINT64_MAX : a + b;
+        }
+    }
+}
+
+/**
+ * Numbers a position within its layer.
+ * @param cells Contents of each cell, in row-major order: 0 for empty,
+ * 1 for X and 2 for O
+ * @param cell_count
+ * @return Rank of the position in the layer of its piece count
+ */
+static uint64_t
+xo_tablebase_rank (const uint8_t *cells, uint8_t cell_count)
+{
+  uint64_t occupied_rank = 0;
+  uint64_t x_rank = 0;
+  uint8_t pieces = 0;
+  uint8_t x_count = 0;
+  for (uint8_t cell = 0; cell < cell_count; cell++)
+    {
+      if (cells[cell] != 0)
+        {
+          pieces++;
+          occupied_rank += xo_tablebase_binomials[cell][pieces];
+          if (cells[cell] == 1)
+            {
+              x_count++;
+              x_rank += xo_tablebase_binomials[pieces - 1][x_count];
+            }
+        }
+    }
+  return occupied_rank * xo_tablebase_binomials[pieces][x_count] + x_rank;
+}
+
+/**
+ * Rebuilds a position from its rank, see xo_tablebase_rank.
+ * @param rank
+ * @param pieces Layer of the position
+ * @param cells Receives the contents of each cell
+ * @param cell_count
+ */
+static void
+xo_tablebase_unrank (uint64_t rank, uint8_t pieces, uint8_t *cells,
+                     uint8_t cell_count)
+{
+  uint8_t x_count = (uint8_t)((pieces + 1) / 2);
+  uint64_t colourings = xo_tablebase_binomials[pieces][x_count];
+  uint64_t occupied_rank = rank / colourings;
+  uint64_t x_rank = rank % colourings;
+  uint8_t occupied[XO_TABLEBASE_MAX_CELLS];
+
+  /* The largest cell whose coefficient fits is the last of the set */
+  uint8_t left = pieces;
+  for (uint8_t cell = cell_count; cell-- > 0;)
+    {
+      cells[cell] = 0;
+      if (left > 0 && xo_tablebase_binomials[cell][left] <= occupied_rank)
+        {
+          occupied_rank -= xo_tablebase_binomials[cell][left];
+          occupied[--left] = cell;
+        }
+    }
+
+  left = x_count;
+  for (uint8_t piece = pieces; piece-- > 0;)
+    {
+      cells[occupied[piece]] = 2;
+      if (left > 0 && xo_tablebase_binomials[piece][left] <= x_rank)
+        {
+          x_rank -= xo_tablebase_binomials[piece][left];
+          cells[occupied[piece]] = 1;
+          left--;
+        }
+    }
+}
+
+/**
+ * Ranks every position one move after a position, in one pass over the
+ * cells. A piece played on a cell keeps the terms of xo_tablebase_rank of the
+ * pieces before it, adds its own, and moves the pieces after it up by one
+ * place, which only changes their terms.
+ * @param cells Position, see xo_tablebase_rank
+ * @param cell_count
+ * @param mover 1 if X plays, 2 if O plays
+ * @param ranks Receives the rank of the position after a move on each empty
+ * cell, in the layer after the position
+ */
+static void
+xo_tablebase_child_ranks (const uint8_t *cells, uint8_t cell_count,
+                          uint8_t mover, uint64_t *ranks)
+{
+  uint8_t pieces = 0;
+  uint8_t x_count = 0;
+  uint8_t x_move = mover == 1;
+  for (uint8_t cell = 0; cell < cell_count; cell++)
+    {
+      pieces = (uint8_t)(pieces + (cells[cell] != 0));
+      x_count = (uint8_t)(x_count + (cells[cell] == 1));
+    }
+
+  /* Terms of the pieces after the cell, moved up by one place */
+  uint64_t occupied_after = 0;
+  uint64_t x_after = 0;
+  uint8_t piece = pieces;
+  uint8_t x_piece = x_count;
+  uint64_t shifted_occupied[XO_TABLEBASE_MAX_CELLS];
+  uint64_t shifted_x[XO_TABLEBASE_MAX_CELLS];
+  for (uint8_t cell = cell_count; cell-- > 0;)
+    {
+      shifted_occupied[cell] = occupied_after;
+      shifted_x[cell] = x_after;
+      if (cells[cell] != 0)
+        {
+          occupied_after += xo_tablebase_binomials[cell][piece + 1];
+          piece--;
+          if (cells[cell] == 1)
+            {
+              x_after += xo_tablebase_binomials[piece + 1][x_piece + x_move];
+              x_piece--;
+            }
+        }
+    }
+
+  uint64_t colourings = xo_tablebase_binomials[pieces + 1][x_count + x_move];
+  uint64_t occupied_before = 0;
+  uint64_t x_before = 0;
+  for (uint8_t cell = 0; cell < cell_count; cell++)
+    {
+      if (cells[cell] == 0)
+        {
+          uint64_t occupied_rank = occupied_before
+                                   + xo_tablebase_binomials[cell][piece + 1]
+                                   + shifted_occupied[cell];
+          uint64_t x_rank = x_before + shifted_x[cell];
+          if (x_move)
+            {
+              x_rank += xo_tablebase_binomials[piece][x_piece + 1];
+            }
+          ranks[cell] = occupied_rank * colourings + x_rank;
+          continue;
+        }
+
+      piece++;
+      occupied_before += xo_tablebase_binomials[cell][piece];
+      if (cells[cell] == 1)
+        {
+          x_piece++;
+          x_before += xo_tablebase_binomials[piece - 1][x_piece];
+        }
+    }
+}
+
+/**
+ * Counts the positions of a layer.
+ * @param cell_count
+ * @param pieces
+ * @return Positions with pieces pieces, or UINT64_MAX if there are too many to
+ * number
+ */
+static uint64_t
+xo_tablebase_layer_size (uint8_t cell_count, uint8_t pieces)
+{
+  uint64_t occupied_sets = xo_tablebase_binomials[cell_count][pieces];
+  uint64_t colourings = xo_tablebase_binomials[pieces][(pieces + 1) / 2];
+  if (occupied_sets == UINT64_MAX || occupied_sets > UINT64_MAX / colourings)
+    {
+      return UINT64_MAX;
+    }
+  return occupied_sets * colourings;
+}
+
+/**
+ * Reads the value of a position from a solved layer.
+ * @param layer
+ * @param rank
+ * @return Value for the side to move
+ */
+static enum xo_tablebase_value_type
+xo_tablebase_layer_value (const struct xo_tablebase_layer *layer,
+                          uint64_t rank)
+{
+  uint64_t bit = 1ull << (rank % 64);
+  if ((layer->wins[rank / 64] & bit) != 0)
+    {
+      return XO_TABLEBASE_WIN;
+    }
+  if ((layer->losses[rank / 64] & bit) != 0)
+    {
+      return XO_TABLEBASE_LOSS;
+    }
+  return XO_TABLEBASE_DRAW;
+}
+
+/**
+ * Gives the value of a position.
+ * @param tablebase
+ * @param cells Contents of each cell, see xo_tablebase_rank
+ * @return Value for the side to move, or XO_TABLEBASE_UNKNOWN if the position
+ * has fewer pieces than the tablebase holds or is not legal
+ */
+static enum xo_tablebase_value_type
+xo_tablebase_probe (const struct xo_tablebase *tablebase, const uint8_t *cells)
+{
+  uint8_t pieces = 0;
+  uint8_t x_count = 0;
+  for (uint8_t cell = 0; cell < tablebase->geometry.cells; cell++)
+    {
+      pieces = (uint8_t)(pieces + (cells[cell] != 0));
+      x_count = (uint8_t)(x_count + (cells[cell] == 1));
+    }
+  if (pieces < tablebase->min_pieces || x_count != (pieces + 1) / 2)
+    {
+      return XO_TABLEBASE_UNKNOWN;
+    }
+  return xo_tablebase_layer_value (
+      &tablebase->layers[pieces],
+      xo_tablebase_rank (cells, (uint8_t)tablebase->geometry.cells));
+}
+
+/**
+ * Gives the value of a position of the board of a tablebase.
+ * @param tablebase
+ * @param board
+ * @return Value for the side to move, see xo_tablebase_probe
+ */
+static enum xo_tablebase_value_type
+xo_tablebase_probe_mnk (const struct xo_tablebase *tablebase,
+                        const struct xo_mnk_board *board)
+{
+  const struct xo_mnk_geometry *geometry = &tablebase->geometry;
+  uint8_t cells[XO_TABLEBASE_MAX_CELLS];
+  if (board->count < tablebase->min_pieces)
+    {
+      return XO_TABLEBASE_UNKNOWN;
+    }
+
+  for (int row = 0; row < geometry->height; row++)
+    {
+      for (int col = 0; col < geometry->width; col++)
+        {
+          uint16_t bit = xo_mnk_cell_bit (geometry, col, row);
+          cells[row * geometry->width + col]
+              = xo_mnk_bits_test (&board->x, bit)   ? 1
+                : xo_mnk_bits_test (&board->o, bit) ? 2
+                                                    : 0;
+        }
+    }
+  return xo_tablebase_probe (tablebase, cells);
+}
+
+/**
+ * Solves one position of a layer from the values of the next layer.
+ * @param tablebase
+ * @param cells Position
+ * @param pieces Pieces of the position
+ * @return Value for the side to move
+ */
+static enum xo_tablebase_value_type
+xo_tablebase_solve_position (const struct xo_tablebase *tablebase,
+                             const uint8_t *cells, uint8_t pieces)
+{
+  const struct xo_mnk_geometry *geometry = &tablebase->geometry;
+  uint8_t mover = pieces % 2 == 0 ? 1 : 2;
+  struct xo_mnk_bits opponent = { 0 };
+  for (uint8_t cell = 0; cell < geometry->cells; cell++)
+    {
+      if (cells[cell] != 0 && cells[cell] != mover)
+        {
+          xo_mnk_bits_toggle (&opponent,
+                              (uint16_t)(cell / geometry->width
+                                             * geometry->stride
+                                         + cell % geometry->width));
+        }
+    }
+
+  /* The last move won, or filled the board */
+  if (tablebase->kernel->has_line (geometry, &opponent))
+    {
+      return XO_TABLEBASE_LOSS;
+    }
+  if (pieces == geometry->cells)
+    {
+      return XO_TABLEBASE_DRAW;
+    }
+
+  const struct xo_tablebase_layer *next = &tablebase->layers[pieces + 1];
+  enum xo_tablebase_value_type value = XO_TABLEBASE_LOSS;
+  uint64_t ranks[XO_TABLEBASE_MAX_CELLS];
+  xo_tablebase_child_ranks (cells, (uint8_t)geometry->cells, mover, ranks);
+  for (uint8_t cell = 0; cell < geometry->cells && value != XO_TABLEBASE_WIN;
+       cell++)
+    {
+      if (cells[cell] != 0)
+        {
+          continue;
+        }
+      enum xo_tablebase_value_type child
+          = xo_tablebase_layer_value (next, ranks[cell]);
+      if (child == XO_TABLEBASE_LOSS)
+        {
+          value = XO_TABLEBASE_WIN;
+        }
+      else if (child == XO_TABLEBASE_DRAW)
+        {
+          value = XO_TABLEBASE_DRAW;
+        }
+    }
+  return value;
+}
+
+/**
+ * Builds the tablebase of an m,n,k game by retrograde analysis, with its
+ * layers allocated from the generic stack.
+ * @param tablebase
+ * @param geometry Board, of at most XO_TABLEBASE_MAX_CELLS cells
+ * @param min_pieces Smallest layer to solve, 0 for the whole game
+ * @param threads
+ * @param b_verbose Print the size, the values and the time of each layer
+ * @return 0 for success
+ */
+static int32_t
+xo_tablebase_build (struct xo_tablebase *tablebase,
+                    const struct xo_mnk_geometry *geometry,
+                    uint8_t min_pieces, int threads, SDL_bool b_verbose)
+{
+  if (geometry->cells > XO_TABLEBASE_MAX_CELLS || min_pieces > geometry->cells)
+    {
+      xo_log_error (SDL_FALSE,
+                    "Tablebases hold at most %d cells, from %u pieces up\n",
+                    XO_TABLEBASE_MAX_CELLS, min_pieces);
+      return 1;
+    }
+
+  xo_tablebase_init_binomials ();
+  *tablebase = (struct xo_tablebase){ 0 };
+  tablebase->geometry = *geometry;
+  tablebase->kernel = xo_mnk_kernel_find (geometry);
+  tablebase->min_pieces = min_pieces;
+
+  uint8_t cell_count = (uint8_t)geometry->cells;
+  for (int layer_pieces = cell_count; layer_pieces >= min_pieces;
+       layer_pieces--)
+    {
+      uint8_t pieces = (uint8_t)layer_pieces;
+      struct xo_tablebase_layer *layer = &tablebase->layers[pieces];
+      layer->size = xo_tablebase_layer_size (cell_count, pieces);
+      if (layer->size == UINT64_MAX)
+        {
+          xo_log_error (SDL_FALSE, "Tablebase layer of %u pieces is too "
+                                   "large\n",
+                        pieces);
+          return 1;
+        }
+
+      size_t words = (size_t)((layer->size + 63) / 64);
+      uint64_t *win_words
+          = (uint64_t *)xo_stack_alloc (generic, words * sizeof (uint64_t));
+      uint64_t *loss_words
+          = (uint64_t *)xo_stack_alloc (generic, words * sizeof (uint64_t));
+      layer->wins = win_words;
+      layer->losses = loss_words;
+      if (win_words == NULL || loss_words == NULL)
+        {
+          xo_log_error (SDL_FALSE,
+                        "Not enough memory for the tablebase layer of %u "
+                        "pieces (%zu KB)\n",
+                        pieces, 2 * words * sizeof (uint64_t) / 1024);
+          return 1;
+        }
+
+      Uint64 start = SDL_GetPerformanceCounter ();
+      uint64_t wins = 0;
+      uint64_t losses = 0;
+#pragma omp parallel for num_threads(threads) schedule(dynamic, 16)           \
+    reduction(+ : wins, losses)
+      for (size_t word = 0; word < words; word++)
+        {
+          uint8_t cells[XO_TABLEBASE_MAX_CELLS];
+          uint64_t win_bits = 0;
+          uint64_t loss_bits = 0;
+          uint64_t first = (uint64_t)word * 64;
+          uint64_t last = SDL_min (first + 64, layer->size);
+          for (uint64_t rank = first; rank < last; rank++)
+            {
+              xo_tablebase_unrank (rank, pieces, cells, cell_count);
+              enum xo_tablebase_value_type value
+                  = xo_tablebase_solve_position (tablebase, cells, pieces);
+              if (value == XO_TABLEBASE_WIN)
+                {
+                  win_bits |= 1ull << (rank - first);
+                  wins++;
+                }
+              else if (value == XO_TABLEBASE_LOSS)
+                {
+                  loss_bits |= 1ull << (rank - first);
+                  losses++;
+                }
+            }
+          win_words[word] = win_bits;
+          loss_words[word] = loss_bits;
+        }
+
+      if (b_verbose)
+        {
+          printf ("%6u %14" SDL_PRIu64 " %14" SDL_PRIu64 " %14" SDL_PRIu64
+                  " %14" SDL_PRIu64 " %10.1f\n",
+                  pieces, layer->size, wins, layer->size - wins - losses,
+                  losses,
+                  (double)(SDL_GetPerformanceCounter () - start) * 1000.0
+                      / (double)SDL_GetPerformanceFrequency ());
+          fflush (stdout);
+        }
+    }
+  return 0;
+}
+
+/**
+ * Writes a tablebase to a file, see struct xo_tablebase_header.
+ * @param tablebase
+ * @param path
+ * @return 0 for success
+ */
+static int32_t
+xo_tablebase_write (const struct xo_tablebase *tablebase, const char *path)
+{
+  const struct xo_mnk_geometry *geometry = &tablebase->geometry;
+  struct xo_tablebase_header header = { 0 };
+  memcpy (header.magic, XO_TABLEBASE_MAGIC, sizeof (header.magic));
+  header.version = XO_TABLEBASE_VERSION;
+  header.width = geometry->width;
+  header.height = geometry->height;
+  header.k = geometry->k;
+  header.min_pieces = tablebase->min_pieces;
+  header.symmetry = XO_TABLEBASE_SYMMETRY_NONE;
+  header.byte_order = 0x01020304;
+
+  uint64_t offset = sizeof (header);
+  for (uint16_t pieces = tablebase->min_pieces; pieces <= geometry->cells;
+       pieces++)
+    {
+      header.offsets[pieces] = offset;
+      offset += 2 * ((tablebase->layers[pieces].size + 63) / 64)
+                * sizeof (uint64_t);
+    }
+
+  FILE *file = fopen (path, "wb");
+  if (file == NULL)
+    {
+      xo_log_error (SDL_FALSE, "Could not open %s\n", path);
+      return 1;
+    }
+
+  size_t failures = fwrite (&header, sizeof (header), 1, file) != 1;
+  for (uint16_t pieces = tablebase->min_pieces; pieces <= geometry->cells;
+       pieces++)
+    {
+      const struct xo_tablebase_layer *layer = &tablebase->layers[pieces];
+      size_t words = (size_t)((layer->size + 63) / 64);
+      failures += fwrite (layer->wins, sizeof (uint64_t), words, file) != words;
+      failures
+          += fwrite (layer->losses, sizeof (uint64_t), words, file) != words;
+    }
+  failures += fclose (file) != 0;
+
+  if (failures != 0)
+    {
+      xo_log_error (SDL_FALSE, "Could not write %s\n", path);
+      return 1;
+    }
+  return 0;
+}
+
+/**
+ * Unmaps the file of a mapped tablebase, which is left empty. A tablebase
+ * built in memory is left as it is.
+ * @param tablebase
+ */
+static void
+xo_tablebase_unmap (struct xo_tablebase *tablebase)
+{
+  if (tablebase->mapping == NULL)
+    {
+      return;
+    }
+#ifdef _WIN32
+  UnmapViewOfFile (tablebase->mapping);
+#else
+  munmap (tablebase->mapping, tablebase->mapping_size);
+#endif
+  *tablebase = (struct xo_tablebase){ 0 };
+}
+
+/**
+ * Maps a tablebase file read-only. Its pages are only read from disk when a
+ * probe touches them, and processes mapping the same file share them. The
+ * mapping stays until xo_tablebase_unmap.
+ * @param tablebase Receives the layers, which point into the mapping
+ * @param path
+ * @return 0 for success
+ */
+static int32_t
+xo_tablebase_map (struct xo_tablebase *tablebase, const char *path)
+{
+  void *view = NULL;
+  size_t size = 0;
+  *tablebase = (struct xo_tablebase){ 0 };
+#ifdef _WIN32
+  HANDLE file = CreateFileA (path, GENERIC_READ, FILE_SHARE_READ, NULL,
+                             OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+  LARGE_INTEGER file_size;
+  if (file != INVALID_HANDLE_VALUE && GetFileSizeEx (file, &file_size))
+    {
+      HANDLE mapping
+          = CreateFileMappingA (file, NULL, PAGE_READONLY, 0, 0, NULL);
+      if (mapping != NULL)
+        {
+          view = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0);
+          size = (size_t)file_size.QuadPart;
+          CloseHandle (mapping);
+        }
+    }
+  if (file != INVALID_HANDLE_VALUE)
+    {
+      CloseHandle (file);
+    }
+#else
+  int file = open (path, O_RDONLY);
+  struct stat file_stat;
+  if (file >= 0 && fstat (file, &file_stat) == 0 && file_stat.st_size > 0)
+    {
+      void *mapping = mmap (NULL, (size_t)file_stat.st_size, PROT_READ,
+                            MAP_SHARED, file, 0);
+      if (mapping != MAP_FAILED)
+        {
+          view = mapping;
+          size = (size_t)file_stat.st_size;
+        }
+    }
+  if (file >= 0)
+    {
+      close (file);
+    }
+#endif
+  if (view == NULL)
+    {
+      xo_log_error (SDL_FALSE, "Could not map %s\n", path);
+      return 1;
+    }
+
+  /* Every layer the header announces must be inside the file */
+  const uint8_t *data = (const uint8_t *)view;
+  const struct xo_tablebase_header *header
+      = (const struct xo_tablebase_header *)data;
+  struct xo_mnk_geometry geometry;
+  int32_t result = 0;
+  if (size < sizeof (*header)
+      || memcmp (header->magic, XO_TABLEBASE_MAGIC, sizeof (header->magic))
+             != 0
+      || header->version != XO_TABLEBASE_VERSION
+      || header->byte_order != 0x01020304
+      || header->symmetry != XO_TABLEBASE_SYMMETRY_NONE
+      || xo_mnk_geometry_init (&geometry, header->width, header->height,
+                               header->k)
+             != 0
+      || geometry.cells > XO_TABLEBASE_MAX_CELLS
+      || header->min_pieces > geometry.cells)
+    {
+      result = 1;
+    }
+
+  xo_tablebase_init_binomials ();
+  for (uint16_t pieces = 0; result == 0 && pieces <= geometry.cells; pieces++)
+    {
+      if (pieces < header->min_pieces)
+        {
+          continue;
+        }
+
+      struct xo_tablebase_layer *layer = &tablebase->layers[pieces];
+      layer->size = xo_tablebase_layer_size ((uint8_t)geometry.cells,
+                                             (uint8_t)pieces);
+      uint64_t bytes = 2 * ((layer->size + 63) / 64) * sizeof (uint64_t);
+      uint64_t offset = header->offsets[pieces];
+      if (layer->size == UINT64_MAX || offset % sizeof (uint64_t) != 0
+          || offset < sizeof (*header) || offset > size
+          || bytes > size - offset)
+        {
+          result = 1;
+        }
+      layer->wins = (const uint64_t *)(data + offset);
+      layer->losses = layer->wins + (layer->size + 63) / 64;
+    }
+
+  if (result != 0)
+    {
+      xo_log_error (SDL_FALSE, "%s is not a valid tablebase\n", path);
+      tablebase->mapping = view;
+      tablebase->mapping_size = size;
+      xo_tablebase_unmap (tablebase);
+      return 1;
+    }
+
+  tablebase->geometry = geometry;
+  tablebase->kernel = xo_mnk_kernel_find (&geometry);
+  tablebase->min_pieces = header->min_pieces;
+  tablebase->mapping = view;
+  tablebase->mapping_size = size;
+  return 0;
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Builds the tablebase of an m,n,k game headless, and prints each layer, the
+ * memory used and, for a full tablebase, the value of the game.
+ * @param width
+ * @param height
+ * @param k
+ * @param min_pieces Smallest layer to solve
+ * @param threads
+ * @param path File to write the tablebase to, or NULL
+ * @return 0 for success
+ */
+static int32_t
+xo_tablebase_report (uint8_t width, uint8_t height, uint8_t k,
+                     uint8_t min_pieces, int threads, const char *path)
+{
+  struct xo_mnk_geometry geometry;
+  struct xo_tablebase *tablebase = (struct xo_tablebase *)xo_stack_alloc (
+      generic, sizeof (struct xo_tablebase));
+  if (tablebase == NULL
+      || xo_mnk_geometry_init (&geometry, width, height, k) != 0)
+    {
+      return 1;
+    }
+
+  size_t mark = xo_stack_mark (generic);
+  Uint64 start = SDL_GetPerformanceCounter ();
+  printf ("Tablebase of %ux%u k=%u, from %u pieces, on %d threads\n", width,
+          height, k, min_pieces, threads);
+  printf ("%6s %14s %14s %14s %14s %10s\n", "pieces", "positions", "wins",
+          "draws", "losses", "ms");
+  if (xo_tablebase_build (tablebase, &geometry, min_pieces, threads,
+                          SDL_TRUE)
+      != 0)
+    {
+      return 1;
+    }
+
+  printf ("%zu KB in %.1f s\n", (xo_stack_mark (generic) - mark) / 1024,
+          (double)(SDL_GetPerformanceCounter () - start)
+              / (double)SDL_GetPerformanceFrequency ());
+  if (min_pieces == 0)
+    {
+      static const char *values[] = { "Tie", "X Wins", "O Wins" };
+      printf ("%ux%u k=%u: %s with perfect play\n", width, height, k,
+              values[xo_tablebase_layer_value (&tablebase->layers[0], 0)]);
+    }
+
+  if (path != NULL)
+    {
+      if (xo_tablebase_write (tablebase, path) != 0)
+        {
+          return 1;
+        }
+      printf ("Written to %s\n", path);
+    }
+  return 0;
+}
+#endif
+
+/// CPU
+
+/* Zobrist keys: one random key per side and square, plus one that is mixed in
+ * when X is to move. The hash of a position is the XOR of the keys of its
+ * pieces, so playing a move updates it with a single XOR. */
+static uint64_t xo_cpu_zobrist[2][XO_BOARD_SQUARES];
+static uint64_t xo_cpu_zobrist_side;
+
+/**
+ * Empties an MCTS tree and gives it a pool of nodes, all of them free.
+ * @param mcts
+ * @param nodes
+ * @param capacity
+ */
+static void
+xo_game_cpu_mcts_reset (struct xo_cpu_mcts *mcts,
+                        struct xo_cpu_mcts_node *nodes, uint32_t capacity)
+{
+  mcts->nodes = nodes;
+  mcts->capacity = capacity;
+  mcts->used = 0;
+  mcts->root = XO_CPU_MCTS_NULL;
+  mcts->root_board = (struct xo_board_data){ 0 };
+  mcts->root_side = XO_BIT_MEANING_SIDE_X;
+  mcts->free = XO_CPU_MCTS_NULL;
+  for (uint32_t i = capacity; i-- > 0;)
+    {
+      nodes[i].next = mcts->free;
+      mcts->free = i;
+    }
+}
+
+/**
+ * Fills the symmetry and Zobrist tables and allocates the transposition table
+ * and, for the MCTS engines, the MCTS node pool from the generic stack, with
+ * the sizes found in the configuration, and loads the tablebase of the board
+ * with --cpu-table=tablebase. Must be called once, after xo_init_memory,
+ * before any search.
+ * @param cpu
+ * @param board m,n,k board the game is played on, or NULL for none
+ * @return 0 for success
+ */
+static int32_t
+xo_game_cpu_init (struct xo_cpu *cpu, const struct xo_mnk_geometry *board)
+{
+  xo_board_init_symmetries ();
+  xo_qubic_init ();
+  xo_ultimate_init ();
+
+  uint64_t seed = 0x584F5F43505521ull;
+  for (uint8_t side = 0; side < 2; side++)
+    {
+      for (uint8_t square = 0; square < XO_BOARD_SQUARES; square++)
+        {
+          xo_cpu_zobrist[side][square] = xo_util_splitmix64 (&seed);
+        }
+    }
+  xo_cpu_zobrist_side = xo_util_splitmix64 (&seed);
+
+  /* Round the table down to a power of two so a mask selects the slot */
+  size_t size = cpu->config.tt_size;
+  while ((size & (size - 1)) != 0)
+    {
+      size &= size - 1;
+    }
+
+  cpu->tt.slots = NULL;
+  cpu->tt.mask = 0;
+  if (size > 0)
+    {
+      cpu->tt.slots = (struct xo_cpu_tt_slot *)xo_stack_alloc (
+          generic, size * sizeof (struct xo_cpu_tt_slot));
+      if (cpu->tt.slots == NULL)
+        {
+          xo_log_error (SDL_TRUE,
+                        "Failed to allocate a transposition table of %zu "
+                        "entries\n",
+                        size);
+          return 1;
+        }
+      cpu->tt.mask = size - 1;
+    }
+
+  xo_log_debug (1, SDL_FALSE, "CPU transposition table: %zu entries (%zu KB)",
+                size, size * sizeof (struct xo_cpu_tt_slot) / 1024);
+
+  /* The tablebase of the board, mapped from the file. On 3x3, the file is
+   * generated at build time, and the tablebase is small enough to be built
+   * instead when the file cannot be used. Other boards are searched without
+   * one when the file does not hold them. */
+  cpu->tablebase = NULL;
+  if (cpu->config.table_mode == XO_CPU_TABLE_TABLEBASE && board != NULL)
+    {
+      const char *path = cpu->config.tablebase_path != NULL
+                             ? cpu->config.tablebase_path
+                             : XO_TABLEBASE_PATH;
+      cpu->tablebase = (struct xo_tablebase *)xo_stack_alloc (
+          generic, sizeof (struct xo_tablebase));
+      if (cpu->tablebase == NULL)
+        {
+          return 1;
+        }
+
+      if (xo_tablebase_map (cpu->tablebase, path) == 0
+          && cpu->tablebase->geometry.width == board->width
+          && cpu->tablebase->geometry.height == board->height
+          && cpu->tablebase->geometry.k == board->k)
+        {
+          xo_log_debug (1, SDL_FALSE, "CPU tablebase: %s mapped (%zu KB)",
+                        path, cpu->tablebase->mapping_size / 1024);
+        }
+      else if (!xo_mnk_is_tic_tac_toe (board))
+        {
+          xo_log_error (SDL_FALSE,
+                        "%s is not a tablebase of the %ux%u k=%u board, "
+                        "searching without one\n",
+                        path, board->width, board->height, board->k);
+          xo_tablebase_unmap (cpu->tablebase);
+          cpu->tablebase = NULL;
+        }
+      else
+        {
+          xo_log_debug (1, SDL_TRUE,
+                        "CPU tablebase: %s not usable, building the 3x3 "
+                        "tablebase",
+                        path);
+          xo_tablebase_unmap (cpu->tablebase);
+          if (xo_tablebase_build (cpu->tablebase, board, 0,
+                                  cpu->config.threads, SDL_FALSE)
+              != 0)
+            {
+              xo_log_error (SDL_TRUE, "Failed to build the 3x3 tablebase\n");
+              return 1;
+            }
+        }
+    }
+
+  /* The MCTS node pool, taken once: nodes are recycled through a free list
+   * afterwards */
+  xo_game_cpu_mcts_reset (&cpu->mcts, NULL, 0);
+  cpu->mcts.rng = seed;
+  omp_init_lock (&cpu->mcts.lock);
+  if (cpu->config.engine == XO_CPU_ENGINE_MCTS
+      || cpu->config.engine == XO_CPU_ENGINE_MCTS_ROOT)
+    {
+      struct xo_cpu_mcts_node *nodes
+          = (struct xo_cpu_mcts_node *)xo_stack_alloc (
+              generic,
+              cpu->config.mcts_nodes * sizeof (struct xo_cpu_mcts_node));
+      if (nodes == NULL)
+        {
+          xo_log_error (SDL_TRUE,
+                        "Failed to allocate an MCTS pool of %u nodes\n",
+                        cpu->config.mcts_nodes);
+          return 1;
+        }
+      xo_game_cpu_mcts_reset (&cpu->mcts, nodes, cpu->config.mcts_nodes);
+      xo_log_debug (1, SDL_FALSE, "CPU MCTS pool: %u nodes (%zu KB)",
+                    cpu->mcts.capacity,
+                    cpu->mcts.capacity * sizeof (struct xo_cpu_mcts_node)
+                        / 1024);
+    }
+  return 0;
+}
+
+/**
+ * Computes the Zobrist hashes of a position from scratch, one per symmetry
+ * frame: hashes[t] is the hash of the position transformed by t. The search
+ * then keeps them up to date incrementally.
+ * @param board_data
+ * @param side Side to move
+ * @param hashes Receives the XO_BOARD_SYMMETRIES hashes
+ */
+static void
+xo_game_cpu_hash_board (struct xo_board_data *board_data,
+                        enum xo_bit_meaning_type side,
+                        uint64_t hashes[XO_BOARD_SYMMETRIES])
+{
+  for (uint8_t transform = 0; transform < XO_BOARD_SYMMETRIES; transform++)
+    {
+      const uint8_t *squares = xo_board_symmetry_squares[transform];
+      uint64_t hash = side == XO_BIT_MEANING_SIDE_X ? xo_cpu_zobrist_side : 0;
+      for (uint8_t square = 0; square < XO_BOARD_SQUARES; square++)
+        {
+          if ((board_data->x & (1u << square)) != 0)
+            {
+              hash ^= xo_cpu_zobrist[0][squares[square]];
+            }
+          else if ((board_data->o & (1u << square)) != 0)
+            {
+              hash ^= xo_cpu_zobrist[1][squares[square]];
+            }
+        }
+      hashes[transform] = hash;
+    }
+}
+
+/**
+ * Picks the canonical key of a position out of its per-frame hashes: the
+ * smallest one. Symmetric positions have the same set of hashes, hence the
+ * same key, so they share one transposition table entry.
+ * @param hashes
+ * @param key Receives the canonical key
+ * @return The xo_board_symmetry_type of the frame the key belongs to. Moves
+ * are stored in that frame.
+ */
+static uint8_t
+xo_game_cpu_canonical_key (const uint64_t hashes[XO_BOARD_SYMMETRIES],
+                           uint64_t *key)
+{
+  uint8_t best_transform = XO_BOARD_SYMMETRY_IDENTITY;
+  for (uint8_t transform = 1; transform < XO_BOARD_SYMMETRIES; transform++)
+    {
+      if (hashes[transform] < hashes[best_transform])
+        {
+          best_transform = transform;
+        }
+    }
+  *key = hashes[best_transform];
+  return best_transform;
+}
+
+/**
+ * Looks a position up in the transposition table. Safe to call while other
+ * threads probe and store, see xo_cpu_tt_slot.
+ * @param cpu
+ * @param hash
+ * @param entry Receives the matching entry
+ * @return SDL_TRUE when the position is stored
+ */
+static SDL_bool
+xo_game_cpu_tt_probe (struct xo_cpu *cpu, uint64_t hash,
+                      struct xo_cpu_tt_entry *entry)
+{
+  if (cpu->tt.slots == NULL)
+    {
+      return SDL_FALSE;
+    }
+
+  cpu->stats.tt_probes++;
+  struct xo_cpu_tt_slot *slot = &cpu->tt.slots[hash & cpu->tt.mask];
+  uint64_t check;
+  uint64_t data;
+#pragma omp atomic read
+  check = slot->check;
+#pragma omp atomic read
+  data = slot->data;
+
+  entry->key = check ^ data;
+  entry->score = (int16_t)(data & 0xFFFF);
+  entry->bound = (uint8_t)((data >> 16) & 0xFF);
+  entry->move = (int16_t)((data >> 24) & 0xFFFF);
+  entry->depth = (uint8_t)((data >> 40) & 0xFF);
+  if (entry->bound == XO_CPU_BOUND_NONE || entry->key != hash)
+    {
+      return SDL_FALSE;
+    }
+
+  cpu->stats.tt_hits++;
+  return SDL_TRUE;
+}
+
+/**
+ * Stores a search result in the transposition table, replacing whatever
+ * occupied the slot. Safe to call while other threads probe and store, see
+ * xo_cpu_tt_slot.
+ * @param cpu
+ * @param hash
+ * @param score
+ * @param bound How the score relates to the real value of the position
+ * @param move Best move found, or XO_CPU_NO_MOVE
+ * @param depth Plies searched below the position
+ */
+static void
+xo_game_cpu_tt_store (struct xo_cpu *cpu, uint64_t hash, int32_t score,
+                      enum xo_cpu_bound_type bound, int16_t move,
+                      uint8_t depth)
+{
+  if (cpu->tt.slots == NULL)
+    {
+      return;
+    }
+
+  cpu->stats.tt_stores++;
+  struct xo_cpu_tt_slot *slot = &cpu->tt.slots[hash & cpu->tt.mask];
+  uint64_t data = (uint64_t)(uint16_t)(int16_t)score
+                  | ((uint64_t)bound << 16)
+                  | ((uint64_t)(uint16_t)move << 24)
+                  | ((uint64_t)depth << 40);
+#pragma omp atomic write
+  slot->check = hash ^ data;
+#pragma omp atomic write
+  slot->data = data;
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Empties the transposition table.
+ * @param cpu
+ */
+static void
+xo_game_cpu_tt_clear (struct xo_cpu *cpu)
+{
+  if (cpu->tt.slots != NULL)
+    {
+      memset (cpu->tt.slots, 0,
+              (cpu->tt.mask + 1) * sizeof (struct xo_cpu_tt_slot));
+    }
+}
+#endif
+
+/**
+ * Tells whether the deadline of the search has passed.
+ * @param cpu
+ * @return
+ */
+static SDL_bool
+xo_game_cpu_past_deadline (struct xo_cpu *cpu)
+{
+  return cpu->budget != NULL && cpu->budget->deadline != 0
+         && SDL_GetPerformanceCounter () >= cpu->budget->deadline;
+}
+
+/**
+ * Tells whether the search ran out of its time or node budget. The deadline
+ * is only read every 256 nodes. Once a thread finds the budget spent, it
+ * is spent for all the threads of the search.
+ * @param cpu
+ * @return
+ */
+static SDL_bool
+xo_game_cpu_out_of_budget (struct xo_cpu *cpu)
+{
+  struct xo_cpu_budget *budget = cpu->budget;
+  if (budget == NULL)
+    {
+      return SDL_FALSE;
+    }
+
+  int aborted;
+#pragma omp atomic read
+  aborted = budget->aborted;
+  if (aborted == 0
+      && ((cpu->node_limit != 0 && cpu->stats.nodes >= cpu->node_limit)
+          || ((cpu->stats.nodes & 0xFF) == 0
+              && xo_game_cpu_past_deadline (cpu))))
+    {
+      aborted = 1;
+#pragma omp atomic write
+      budget->aborted = 1;
+    }
+  return aborted != 0;
+}
+
+/**
+ * Tells whether the search must stop, because another thread asked for it or
+ * because its budget is spent. The results of a stopped search are
+ * meaningless and must not be stored.
+ * @param cpu
+ * @return
+ */
+static SDL_bool
+xo_game_cpu_stopped (struct xo_cpu *cpu)
+{
+  int stop = xo_game_cpu_out_of_budget (cpu);
+  if (cpu->stop != NULL && stop == 0)
+    {
+#pragma omp atomic read
+      stop = *cpu->stop;
+    }
+
+  /* A cutoff at any enclosing split point also makes the search useless */
+  for (struct xo_cpu_split *split = cpu->split; split != NULL && stop == 0;
+       split = split->parent)
+    {
+#pragma omp atomic read
+      stop = split->cutoff;
+    }
+  return stop != 0;
+}
+
+/**
+ * Updates the per-frame Zobrist hashes of a position for a move.
+ * @param hashes Hashes before the move
+ * @param side Side playing the move
+ * @param square
+ * @param child_hashes Receives the hashes after the move
+ */
+static void
+xo_game_cpu_child_hashes (const uint64_t hashes[XO_BOARD_SYMMETRIES],
+                          enum xo_bit_meaning_type side, uint8_t square,
+                          uint64_t child_hashes[XO_BOARD_SYMMETRIES])
+{
+  for (uint8_t transform = 0; transform < XO_BOARD_SYMMETRIES; transform++)
+    {
+      child_hashes[transform]
+          = hashes[transform] ^ xo_cpu_zobrist_side
+            ^ xo_cpu_zobrist[side == XO_BIT_MEANING_SIDE_O]
+                            [xo_board_symmetry_squares[transform][square]];
+    }
+}
+
+/**
+ * Adds the counters of a search to a total.
+ * @param total
+ * @param part
+ */
+static void
+xo_game_cpu_stats_add (struct xo_cpu_stats *total,
+                       const struct xo_cpu_stats *part)
+{
+  total->nodes += part->nodes;
+  total->tt_probes += part->tt_probes;
+  total->tt_hits += part->tt_hits;
+  total->tt_stores += part->tt_stores;
+  total->steals += part->steals;
+  total->idle_ticks += part->idle_ticks;
+  total->search_ticks += part->search_ticks;
+  total->researches += part->researches;
+  total->cutoffs += part->cutoffs;
+  total->first_move_cutoffs += part->first_move_cutoffs;
+}
+
+/**
+ * Creates per-thread copies of a search context from minimax_stack. The
+ * copies share the configuration, the transposition table and the budget of
+ * cpu, but have their own statistics and per-ply scratch memory. The nodes
+ * left in the budget are divided among the copies.
+ * @param cpu
+ * @param count Number of copies
+ * @return The copies, or NULL when minimax_stack is exhausted
+ */
+static struct xo_cpu *
+xo_game_cpu_fork (struct xo_cpu *cpu, int count)
+{
+  struct xo_cpu *workers = (struct xo_cpu *)xo_stack_alloc (
+      minimax_stack, (size_t)count * sizeof (struct xo_cpu));
+  if (workers == NULL)
+    {
+      return NULL;
+    }
+
+  for (int i = 0; i < count; i++)
+    {
+      workers[i] = *cpu;
+      workers[i].stats = (struct xo_cpu_stats){ 0 };
+      workers[i].id = i;
+      if (cpu->node_limit != 0)
+        {
+          workers[i].node_limit
+              = cpu->node_limit > cpu->stats.nodes
+                    ? SDL_max (1, (cpu->node_limit - cpu->stats.nodes)
+                                      / (uint64_t)count)
+                    : 1;
+        }
+      workers[i].plies = (struct xo_cpu_ply *)xo_stack_alloc (
+          minimax_stack, (XO_BOARD_SQUARES + 1) * sizeof (struct xo_cpu_ply));
+      if (workers[i].plies == NULL)
+        {
+          return NULL;
+        }
+    }
+
+  return workers;
+}
+
+/**
+ * Scores a finished game from the point of view of O: 0 for a tie, and for a
+ * win, 1 plus the number of squares left empty, negated when X won. Faster
+ * wins score higher, and the score depends on the position only, not on the
+ * path to it, so the transposition table stores it as it is.
+ * @param board_data
+ * @param state Result of the game on board_data
+ * @return
+ */
+static int32_t
+xo_game_cpu_score_final (const struct xo_board_data *board_data,
+                         enum xo_win_state_type state)
+{
+  if (state == XO_WIN_STATE_TIE || state == XO_WIN_STATE_NONE)
+    {
+      return 0;
+    }
+
+  int32_t score = 1 + xo_board_empty_count (board_data);
+  return state == XO_WIN_STATE_O_WIN ? score : -score;
+}
+
+/**
+ * Records a move that caused a cutoff, for the move ordering heuristics and
+ * the statistics.
+ * @param cpu
+ * @param side Side that played the move
+ * @param ply
+ * @param depth Plies searched below the move's position
+ * @param square
+ * @param index Position of the move in the search order
+ */
+static void
+xo_game_cpu_record_cutoff (struct xo_cpu *cpu, enum xo_bit_meaning_type side,
+                           uint8_t ply, uint8_t depth, uint8_t square,
+                           uint8_t index)
+{
+  cpu->stats.cutoffs++;
+  if (index == 0)
+    {
+      cpu->stats.first_move_cutoffs++;
+    }
+
+  if (cpu->killers[ply][0] != (int8_t)square)
+    {
+      cpu->killers[ply][1] = cpu->killers[ply][0];
+      cpu->killers[ply][0] = (int8_t)square;
+    }
+  cpu->history[side == XO_BIT_MEANING_SIDE_O][square]
+      += (uint32_t)depth * depth;
+}
+
+/**
+ * Prepares the move ordering heuristics for a new CPU turn: the killer moves
+ * belong to the positions of the last turn and are cleared, and the history
+ * scores are halved so that recent cutoffs weigh more.
+ * @param cpu
+ */
+static void
+xo_game_cpu_age_heuristics (struct xo_cpu *cpu)
+{
+  for (uint8_t ply = 0; ply <= XO_BOARD_SQUARES; ply++)
+    {
+      cpu->killers[ply][0] = XO_CPU_NO_MOVE;
+      cpu->killers[ply][1] = XO_CPU_NO_MOVE;
+    }
+  for (uint8_t side = 0; side < 2; side++)
+    {
+      for (uint8_t square = 0; square < XO_BOARD_SQUARES; square++)
+        {
+          cpu->history[side][square] /= 2;
+        }
+    }
+}
+
+/* Square visiting orders used by the search, see xo_cpu_move_order_type. */
+static const uint8_t xo_cpu_move_order_natural[XO_BOARD_SQUARES]
+    = { 0, 3, 6, 1, 4, 7, 2, 5, 8 };
+static const uint8_t xo_cpu_move_order_static[XO_BOARD_SQUARES]
+    = { 4, 0, 2, 6, 8, 1, 3, 5, 7 };
+
+/* Center 0, corners 1, edges 2. History scores only reorder squares of the
+ * same class: across classes, the static order is the better guide. */
+static const uint8_t xo_cpu_square_class[XO_BOARD_SQUARES]
+    = { 1, 2, 1, 2, 0, 2, 1, 2, 1 };
+
+/**
+ * Lists the empty squares of a board in the order they should be searched.
+ * Good moves searched first produce more alpha-beta cutoffs. When the position
+ * is symmetric, only one move out of each group of equivalent moves is kept.
+ * Lazy SMP helpers start the order at a different square
+ * (cpu->perturbation), so that they explore the tree in another order.
+ * @param cpu
+ * @param board_data
+ * @param side Side to move
+ * @param ply Distance from the root of the search, for the killer moves
+ * @param hash_move Square to try before all others, or XO_CPU_NO_MOVE
+ * @param moves Receives the square indices (row * XO_BOARD_SIZE + col)
+ * @return Number of moves written
+ */
+static uint8_t
+xo_game_cpu_order_moves (struct xo_cpu *cpu, struct xo_board_data *board_data,
+                         enum xo_bit_meaning_type side, uint8_t ply,
+                         int8_t hash_move, uint8_t moves[XO_BOARD_SQUARES])
+{
+  const uint8_t *order
+      = cpu->config.move_order == XO_CPU_MOVE_ORDER_NATURAL
+            ? xo_cpu_move_order_natural
+            : xo_cpu_move_order_static;
+  uint16_t empty
+      = (uint16_t)(~(board_data->x | board_data->o) & XO_BOARD_FULL_MASK);
+  uint8_t symmetries = xo_board_symmetry_stabilizer (board_data);
+  uint8_t count = 0;
+
+  if (hash_move != XO_CPU_NO_MOVE && (empty & (1u << hash_move)) != 0)
+    {
+      moves[count++] = (uint8_t)hash_move;
+    }
+
+  for (uint8_t i = 0; i < XO_BOARD_SQUARES; i++)
+    {
+      uint8_t square = order[(i + cpu->perturbation) % XO_BOARD_SQUARES];
+      if ((empty & (1u << square)) != 0 && square != hash_move)
+        {
+          moves[count++] = square;
+        }
+    }
+
+  if (cpu->config.move_order == XO_CPU_MOVE_ORDER_DYNAMIC)
+    {
+      /* The killer moves of the ply come right after the hash move */
+      uint8_t first = hash_move != XO_CPU_NO_MOVE && count > 0
+                              && moves[0] == (uint8_t)hash_move
+                          ? 1
+                          : 0;
+      for (uint8_t k = 0; k < 2; k++)
+        {
+          for (uint8_t i = first; i < count; i++)
+            {
+              if (moves[i] == (uint8_t)cpu->killers[ply][k])
+                {
+                  memmove (&moves[first + 1], &moves[first], i - first);
+                  moves[first++] = (uint8_t)cpu->killers[ply][k];
+                  break;
+                }
+            }
+        }
+
+      /* The others by history score within each square class, keeping the
+       * static order on ties */
+      const uint32_t *history = cpu->history[side == XO_BIT_MEANING_SIDE_O];
+      for (uint8_t i = (uint8_t)(first + 1); i < count; i++)
+        {
+          uint8_t square = moves[i];
+          uint8_t j = i;
+          for (; j > first
+                 && xo_cpu_square_class[moves[j - 1]]
+                        == xo_cpu_square_class[square]
+                 && history[moves[j - 1]] < history[square];
+               j--)
+            {
+              moves[j] = moves[j - 1];
+            }
+          moves[j] = square;
+        }
+    }
+
+  if (symmetries == (1u << XO_BOARD_SYMMETRY_IDENTITY))
+    {
+      return count;
+    }
+
+  /* Drop the moves that are images of an earlier move */
+  uint16_t covered = 0;
+  uint8_t kept = 0;
+  for (uint8_t i = 0; i < count; i++)
+    {
+      if ((covered & (1u << moves[i])) != 0)
+        {
+          continue;
+        }
+      for (uint8_t transform = 0; transform < XO_BOARD_SYMMETRIES;
+           transform++)
+        {
+          if ((symmetries & (1u << transform)) != 0)
+            {
+              covered |= (uint16_t)(
+                  1u << xo_board_symmetry_squares[transform][moves[i]]);
+            }
+        }
+      moves[kept++] = moves[i];
+    }
+
+  return kept;
+}
+
+static struct xo_cpu_response
+xo_game_cpu_minimax_eval (struct xo_cpu *cpu, struct xo_board_data *last_board,
+                          enum xo_bit_meaning_type side, uint8_t ply,
+                          int32_t alpha, int32_t beta);
+
+/**
+ * Pushes a job at the bottom of the deque of its owner.
+ * @param deque
+ * @param split
+ * @param square
+ * @return SDL_FALSE when the deque is full
+ */
+static SDL_bool
+xo_game_cpu_deque_push (struct xo_cpu_deque *deque,
+                        struct xo_cpu_split *split, uint8_t square)
+{
+  SDL_bool b_pushed = SDL_FALSE;
+
+  omp_set_lock (&deque->lock);
+  if (deque->top == deque->bottom)
+    {
+      deque->top = deque->bottom = 0;
+    }
+  if (deque->bottom < XO_CPU_DEQUE_SIZE)
+    {
+      deque->jobs[deque->bottom++] = (struct xo_cpu_job){ split, square };
+      b_pushed = SDL_TRUE;
+    }
+  omp_unset_lock (&deque->lock);
+
+  return b_pushed;
+}
+
+/**
+ * Pops the newest job of a deque, if it belongs to the given split point.
+ * @param deque
+ * @param split
+ * @param job Receives the job
+ * @return
+ */
+static SDL_bool
+xo_game_cpu_deque_pop (struct xo_cpu_deque *deque, struct xo_cpu_split *split,
+                       struct xo_cpu_job *job)
+{
+  SDL_bool b_popped = SDL_FALSE;
+
+  omp_set_lock (&deque->lock);
+  if (deque->bottom > deque->top
+      && deque->jobs[deque->bottom - 1].split == split)
+    {
+      *job = deque->jobs[--deque->bottom];
+      b_popped = SDL_TRUE;
+    }
+  omp_unset_lock (&deque->lock);
+
+  return b_popped;
+}
+
+/**
+ * Tells whether a split point is below another one, or is the same one.
+ * @param split
+ * @param ancestor
+ * @return
+ */
+static SDL_bool
+xo_game_cpu_split_is_under (const struct xo_cpu_split *split,
+                            const struct xo_cpu_split *ancestor)
+{
+  for (; split != NULL; split = split->parent)
+    {
+      if (split == ancestor)
+        {
+          return SDL_TRUE;
+        }
+    }
+  return SDL_FALSE;
+}
+
+/**
+ * Steals the oldest job of the first other thread that has one. A thread
+ * waiting at a split point only takes the jobs below it (leapfrogging): they
+ * help finish the split point, and use the per-ply scratch memory of deeper
+ * plies only, which the suspended search above does not need.
+ * @param cpu The thief
+ * @param under Split point the jobs must be under, or NULL for any job
+ * @param job Receives the job
+ * @return
+ */
+static SDL_bool
+xo_game_cpu_deque_steal (struct xo_cpu *cpu, const struct xo_cpu_split *under,
+                         struct xo_cpu_job *job)
+{
+  struct xo_cpu_ybwc *ybwc = cpu->ybwc;
+
+  for (int i = 1; i < ybwc->thread_count; i++)
+    {
+      struct xo_cpu_deque *deque
+          = &ybwc->deques[(cpu->id + i) % ybwc->thread_count];
+      SDL_bool b_stolen = SDL_FALSE;
+
+      omp_set_lock (&deque->lock);
+      if (deque->bottom > deque->top
+          && (under == NULL
+              || xo_game_cpu_split_is_under (deque->jobs[deque->top].split,
+                                             under)))
+        {
+          *job = deque->jobs[deque->top++];
+          b_stolen = SDL_TRUE;
+        }
+      omp_unset_lock (&deque->lock);
+
+      if (b_stolen)
+        {
+          cpu->stats.steals++;
+          return SDL_TRUE;
+        }
+    }
+
+  return SDL_FALSE;
+}
+
+/**
+ * Searches one move of a split point and merges its score into the split
+ * point. The job is skipped when the split point, or one enclosing it, was
+ * cut off in the meantime.
+ * @param cpu The thread running the job
+ * @param job
+ */
+static void
+xo_game_cpu_ybwc_run (struct xo_cpu *cpu, const struct xo_cpu_job *job)
+{
+  struct xo_cpu_split *split = job->split;
+  struct xo_cpu_split *saved_split = cpu->split;
+  int32_t alpha;
+  int32_t beta;
+
+  cpu->split = split;
+#pragma omp atomic read
+  alpha = split->alpha;
+#pragma omp atomic read
+  beta = split->beta;
+
+  if (!xo_game_cpu_stopped (cpu) && alpha < beta)
+    {
+      struct xo_board_data board = split->board;
+      enum xo_bit_meaning_type other_side
+          = split->side == XO_BIT_MEANING_SIDE_O ? XO_BIT_MEANING_SIDE_X
+                                                 : XO_BIT_MEANING_SIDE_O;
+      int32_t score;
+
+      cpu->stats.nodes++;
+      if (xo_board_make_move (&board, split->side, job->square))
+        {
+          score = xo_game_cpu_score_final (
+              &board, split->side == XO_BIT_MEANING_SIDE_O
+                          ? XO_WIN_STATE_O_WIN
+                          : XO_WIN_STATE_X_WIN);
+        }
+      else if (xo_board_check_if_full (&board))
+        {
+          score = 0;
+        }
+      else
+        {
+          xo_game_cpu_child_hashes (split->hashes, split->side, job->square,
+                                    cpu->plies[split->ply + 1].hashes);
+          score = xo_game_cpu_minimax_eval (cpu, &board, other_side,
+                                            (uint8_t)(split->ply + 1), alpha,
+                                            beta)
+                      .score;
+        }
+
+      if (!xo_game_cpu_stopped (cpu))
+        {
+#pragma omp critical(xo_cpu_ybwc)
+          {
+            if (split->side == XO_BIT_MEANING_SIDE_O
+                    ? score > split->best_score
+                    : score < split->best_score)
+              {
+                split->best_score = score;
+                split->best_square = (int8_t)job->square;
+                if (split->side == XO_BIT_MEANING_SIDE_O
+                        ? score > split->alpha
+                        : score < split->beta)
+                  {
+                    if (split->side == XO_BIT_MEANING_SIDE_O)
+                      {
+#pragma omp atomic write
+                        split->alpha = score;
+                      }
+                    else
+                      {
+#pragma omp atomic write
+                        split->beta = score;
+                      }
+                  }
+                if (split->alpha >= split->beta)
+                  {
+#pragma omp atomic write
+                    split->cutoff = 1;
+                  }
+              }
+          }
+        }
+    }
+
+  cpu->split = saved_split;
+
+  /* Last access: the owner may leave the split point as soon as it sees 0 */
+#pragma omp flush
+#pragma omp atomic update
+  split->pending--;
+}
+
+/**
+ * Searches the moves of a node after the first one in parallel (Young
+ * Brothers Wait). The moves are pushed as jobs on the deque of the thread,
+ * which then searches the jobs no other thread stole. Until the stolen ones
+ * are done, it helps the threads searching them by stealing the jobs they
+ * split off in turn, and yields the processor when there are none. On
+ * return, alpha, beta and the best score and move are updated as if the
+ * moves had been searched in turn.
+ * @param cpu
+ * @param board Node, with side to move
+ * @param side
+ * @param ply
+ * @param moves Moves left to search
+ * @param move_count
+ * @param alpha
+ * @param beta
+ * @param best_score
+ * @param best_square
+ */
+static void
+xo_game_cpu_ybwc_split (struct xo_cpu *cpu, const struct xo_board_data *board,
+                        enum xo_bit_meaning_type side, uint8_t ply,
+                        const uint8_t *moves, uint8_t move_count,
+                        int32_t *alpha, int32_t *beta, int32_t *best_score,
+                        int8_t *best_square)
+{
+  struct xo_cpu_deque *deque = &cpu->ybwc->deques[cpu->id];
+  struct xo_cpu_split split;
+  struct xo_cpu_job job;
+
+  split.parent = cpu->split;
+  split.board = *board;
+  split.side = side;
+  split.ply = ply;
+  memcpy (split.hashes, cpu->plies[ply].hashes, sizeof (split.hashes));
+  split.alpha = *alpha;
+  split.beta = *beta;
+  split.best_score = *best_score;
+  split.best_square = *best_square;
+  split.pending = move_count;
+  split.cutoff = 0;
+#pragma omp flush
+
+  /* Pushed last first, so that the best moves are popped first */
+  for (int i = move_count - 1; i >= 0; i--)
+    {
+      if (!xo_game_cpu_deque_push (deque, &split, moves[i]))
+        {
+          job = (struct xo_cpu_job){ &split, moves[i] };
+          xo_game_cpu_ybwc_run (cpu, &job);
+        }
+    }
+
+  while (xo_game_cpu_deque_pop (deque, &split, &job))
+    {
+      xo_game_cpu_ybwc_run (cpu, &job);
+    }
+
+  for (;;)
+    {
+      int pending;
+#pragma omp atomic read
+      pending = split.pending;
+      if (pending == 0)
+        {
+          break;
+        }
+      if (xo_game_cpu_deque_steal (cpu, &split, &job))
+        {
+          xo_game_cpu_ybwc_run (cpu, &job);
+        }
+      else
+        {
+          Uint64 idle_start = SDL_GetPerformanceCounter ();
+          xo_util_yield ();
+          cpu->stats.idle_ticks += SDL_GetPerformanceCounter () - idle_start;
+        }
+    }
+#pragma omp flush
+
+  *alpha = split.alpha;
+  *beta = split.beta;
+  *best_score = split.best_score;
+  *best_square = split.best_square;
+}
+
+/**
+ * This function conducts a minimax evaluation of the provided board, with
+ * alpha-beta pruning. O maximizes the score and X minimizes it. Called with
+ * the full (-XO_CPU_SCORE_INFINITY, XO_CPU_SCORE_INFINITY) window, the score
+ * is exact; otherwise it is only a bound when it falls outside the window.
+ * Results are shared between transpositions and symmetric positions through
+ * the cpu->tt table.
+ * Moves are played and taken back in place on last_board, which is left
+ * unchanged on return, and nothing is allocated. The search returns at once,
+ * with a meaningless result, when it is stopped (see xo_game_cpu_stopped).
+ * The game must not be over on last_board: terminal children are scored from
+ * the move that ends them. Under the YBWC engine, the moves after the first
+ * one are shared out among threads (see xo_game_cpu_ybwc_split).
+ * @param cpu Search configuration, statistics and per-ply scratch memory.
+ * cpu->plies[ply].hashes holds the Zobrist hashes of last_board with side to
+ * move, one per symmetry frame (see xo_game_cpu_hash_board).
+ * @param last_board
+ * @param side
+ * @param ply Distance from the root of the search
+ * @param alpha Score O is already assured of
+ * @param beta Score X is already assured of
+ * @return
+ */
+static struct xo_cpu_response
+xo_game_cpu_minimax_eval (struct xo_cpu *cpu, struct xo_board_data *last_board,
+                          enum xo_bit_meaning_type side, uint8_t ply,
+                          int32_t alpha, int32_t beta)
+{
+  struct xo_cpu_response new_response = { 0 };
+  const uint64_t *hashes = cpu->plies[ply].hashes;
+
+  if (xo_game_cpu_stopped (cpu))
+    {
+      return new_response;
+    }
+
+  /* Beyond the horizon of the iteration, the position is scored as a tie */
+  if (ply >= cpu->max_ply)
+    {
+      return new_response;
+    }
+  uint8_t empty_count = xo_board_empty_count (last_board);
+  uint8_t depth = (uint8_t)SDL_min (cpu->max_ply - ply, empty_count);
+
+  /* Mate distance pruning: no line scores better than a win with the next
+   * move, nor worse than a loss to the move after it. A window outside these
+   * bounds is decided without searching. */
+  int32_t upper = side == XO_BIT_MEANING_SIDE_O ? empty_count
+                                                : empty_count - 1;
+  int32_t lower = side == XO_BIT_MEANING_SIDE_O ? 1 - empty_count
+                                                : -(int32_t)empty_count;
+  if (upper <= alpha || lower >= beta)
+    {
+      new_response.score = upper <= alpha ? upper : lower;
+      return new_response;
+    }
+  alpha = SDL_max (alpha, lower);
+  beta = SDL_min (beta, upper);
+
+  /* A stored result can answer the node outright, or at least tell which
+   * move to try first. Stored moves live in the frame of the canonical key
+   * and are mapped back to this board. Only results searched at least as
+   * deep answer the node. */
+  uint64_t key;
+  uint8_t frame = xo_game_cpu_canonical_key (hashes, &key);
+  int8_t hash_move = XO_CPU_NO_MOVE;
+  struct xo_cpu_tt_entry entry;
+  if (xo_game_cpu_tt_probe (cpu, key, &entry))
+    {
+      if (entry.move != XO_CPU_NO_MOVE)
+        {
+          hash_move = (int8_t)xo_board_symmetry_squares
+              [xo_board_symmetry_inverse[frame]][entry.move];
+        }
+      if (entry.depth >= depth
+          && (entry.bound == XO_CPU_BOUND_EXACT
+              || (entry.bound == XO_CPU_BOUND_LOWER && entry.score >= beta)
+              || (entry.bound == XO_CPU_BOUND_UPPER && entry.score <= alpha)))
+        {
+          new_response.score = entry.score;
+          new_response.has_move = hash_move != XO_CPU_NO_MOVE;
+          new_response.move = (SDL_Point){ hash_move % XO_BOARD_SIZE,
+                                           hash_move / XO_BOARD_SIZE };
+          return new_response;
+        }
+    }
+
+  int32_t alpha_start = alpha;
+  int32_t beta_start = beta;
+  enum xo_bit_meaning_type other_side = side == XO_BIT_MEANING_SIDE_O
+                                            ? XO_BIT_MEANING_SIDE_X
+                                            : XO_BIT_MEANING_SIDE_O;
+
+  /* Set the best score depending on which side is simulated. */
+  int32_t best_score = side == XO_BIT_MEANING_SIDE_O ? INT32_MIN : INT32_MAX;
+  int8_t best_square = XO_CPU_NO_MOVE;
+
+  uint8_t *moves = cpu->plies[ply].moves;
+  uint8_t move_count
+      = xo_game_cpu_order_moves (cpu, last_board, side, ply, hash_move, moves);
+
+  /* Iterates over the empty squares, best candidates first */
+  for (uint8_t i = 0; i < move_count && alpha < beta; i++)
+    {
+      uint8_t square = moves[i];
+      int32_t score;
+
+      cpu->stats.nodes++;
+
+      /* Mark the empty square for the simulated side. Checks if the game is
+       * over (the move completes a line or fills the board). */
+      if (xo_board_make_move (last_board, side, square))
+        {
+          enum xo_win_state_type state = side == XO_BIT_MEANING_SIDE_O
+                                             ? XO_WIN_STATE_O_WIN
+                                             : XO_WIN_STATE_X_WIN;
+          score = xo_game_cpu_score_final (last_board, state);
+        }
+      else if (xo_board_check_if_full (last_board))
+        {
+          score = 0;
+        }
+      else
+        {
+          xo_game_cpu_child_hashes (hashes, side, square,
+                                    cpu->plies[ply + 1].hashes);
+
+          /* Create a nested minimax evaluation of the new position. With
+           * PVS, the moves after the first are expected to be worse, which a
+           * null window on the bound of side proves cheaply. A move that
+           * turns out better is searched again with the whole window. */
+          if (i > 0 && cpu->config.b_pvs)
+            {
+              score = side == XO_BIT_MEANING_SIDE_O
+                          ? xo_game_cpu_minimax_eval (cpu, last_board,
+                                                      other_side,
+                                                      (uint8_t)(ply + 1),
+                                                      alpha, alpha + 1)
+                                .score
+                          : xo_game_cpu_minimax_eval (cpu, last_board,
+                                                      other_side,
+                                                      (uint8_t)(ply + 1),
+                                                      beta - 1, beta)
+                                .score;
+              if (score > alpha && score < beta && !xo_game_cpu_stopped (cpu))
+                {
+                  cpu->stats.researches++;
+                  score = xo_game_cpu_minimax_eval (cpu, last_board,
+                                                    other_side,
+                                                    (uint8_t)(ply + 1), alpha,
+                                                    beta)
+                              .score;
+                }
+            }
+          else
+            {
+              score = xo_game_cpu_minimax_eval (cpu, last_board, other_side,
+                                                (uint8_t)(ply + 1), alpha,
+                                                beta)
+                          .score;
+            }
+        }
+
+      xo_board_unmake_move (last_board, side, square);
+
+      if (xo_game_cpu_stopped (cpu))
+        {
+          return new_response;
+        }
+
+      if (side == XO_BIT_MEANING_SIDE_O)
+        {
+          if (score > best_score)
+            {
+              best_score = score;
+              best_square = (int8_t)square;
+            }
+          if (best_score > alpha)
+            {
+              alpha = best_score;
+            }
+        }
+      else
+        {
+          if (score < best_score)
+            {
+              best_score = score;
+              best_square = (int8_t)square;
+            }
+          if (best_score < beta)
+            {
+              beta = best_score;
+            }
+        }
+
+      if (alpha >= beta)
+        {
+          xo_game_cpu_record_cutoff (cpu, side, ply, depth, square, i);
+        }
+
+      /* Young brothers wait: once the first move is known, the others are
+       * searched in parallel */
+      if (i == 0 && cpu->ybwc != NULL && move_count >= XO_CPU_YBWC_MIN_MOVES
+          && alpha < beta)
+        {
+          xo_game_cpu_ybwc_split (cpu, last_board, side, ply, &moves[1],
+                                  (uint8_t)(move_count - 1), &alpha, &beta,
+                                  &best_score, &best_square);
+          if (xo_game_cpu_stopped (cpu))
+            {
+              return new_response;
+            }
+          break;
+        }
+    }
+
+  enum xo_cpu_bound_type bound = XO_CPU_BOUND_EXACT;
+  if (best_score <= alpha_start)
+    {
+      bound = XO_CPU_BOUND_UPPER;
+    }
+  else if (best_score >= beta_start)
+    {
+      bound = XO_CPU_BOUND_LOWER;
+    }
+  /* A win or a loss is proven whatever the horizon: it does not rest on a
+   * position scored at the horizon */
+  xo_game_cpu_tt_store (
+      cpu, key, best_score, bound,
+      best_square == XO_CPU_NO_MOVE
+          ? XO_CPU_NO_MOVE
+          : (int8_t)xo_board_symmetry_squares[frame][best_square],
+      best_score != 0 ? empty_count : depth);
+
+  new_response.score = best_score;
+  new_response.has_move = best_square != XO_CPU_NO_MOVE;
+  new_response.move = (SDL_Point){ best_square % XO_BOARD_SIZE,
+                                   best_square / XO_BOARD_SIZE };
+  return new_response;
+}
+
+/**
+ * Bad version of the cpu AI which just picks the first available square
+ * left-right, top-down. I put this while testing the minimax when it is
+ * crashing. Leaving it here in case I rework AI and need it again.
+ * @param app
+ */
+// NOW DISABLED
+
+// static SDL_Point
+// xo_game_cpu_find_next_play_BAD (struct xo_app *app)
+//{
+//  for (int row = 0; row < 3; row++)
+//    {
+//      for (int col = 0; col < 3; col++)
+//        {
+//          if (xo_board_bit_check_at (app->game->board->data,
+//                                     XO_BIT_MEANING_EMPTY, col, row)
+//              == SDL_TRUE)
+//            {
+//              return (SDL_Point){ col, row };
+//            }
+//        }
+//    }
+//
+//  return (SDL_Point){ -1, -1 };
+//}
+
+/**
+ * Searches a position on the calling thread.
+ * @param cpu
+ * @param root Position to search, which must not be over
+ * @param side Side to move
+ * @param alpha Window of the root, as in xo_game_cpu_minimax_eval
+ * @param beta
+ * @return
+ */
+static struct xo_cpu_response
+xo_game_cpu_search_serial (struct xo_cpu *cpu, struct xo_board_data *root,
+                           enum xo_bit_meaning_type side, int32_t alpha,
+                           int32_t beta)
+{
+  struct xo_cpu_response response = { 0 };
+
+  /* One ply of scratch memory per square, plus the root */
+  cpu->plies = (struct xo_cpu_ply *)xo_stack_alloc (
+      minimax_stack, (XO_BOARD_SQUARES + 1) * sizeof (struct xo_cpu_ply));
+  if (cpu->plies == NULL)
+    {
+      return response;
+    }
+
+  xo_game_cpu_hash_board (root, side, cpu->plies[0].hashes);
+
+  cpu->stats.nodes++;
+  response = xo_game_cpu_minimax_eval (cpu, root, side, 0, alpha, beta);
+  cpu->plies = NULL;
+  return response;
+}
+
+/**
+ * Searches a position by sharing its moves out among OpenMP threads. Each
+ * thread plays its moves on a private copy of the board and searches them
+ * with the best score found so far by any thread as its bound, so that a
+ * good move found by one thread prunes the searches of the others. The
+ * threads share the transposition table.
+ * @param cpu
+ * @param root Position to search, which must not be over
+ * @param side Side to move
+ * @param alpha Window of the root, as in xo_game_cpu_minimax_eval
+ * @param beta
+ * @return The same score as xo_game_cpu_search_serial. Among moves of equal
+ * score, the one returned depends on thread timing.
+ */
+static struct xo_cpu_response
+xo_game_cpu_search_root_split (struct xo_cpu *cpu, struct xo_board_data *root,
+                               enum xo_bit_meaning_type side, int32_t alpha,
+                               int32_t beta)
+{
+  struct xo_cpu_response response = { 0 };
+  int thread_count = cpu->config.threads;
+  struct xo_cpu *workers = xo_game_cpu_fork (cpu, thread_count);
+  if (workers == NULL)
+    {
+      return response;
+    }
+
+  /* The root moves, with the move of an earlier search first */
+  uint64_t hashes[XO_BOARD_SYMMETRIES];
+  xo_game_cpu_hash_board (root, side, hashes);
+  uint64_t key;
+  uint8_t frame = xo_game_cpu_canonical_key (hashes, &key);
+  int8_t hash_move = XO_CPU_NO_MOVE;
+  struct xo_cpu_tt_entry entry;
+  if (xo_game_cpu_tt_probe (cpu, key, &entry) && entry.move != XO_CPU_NO_MOVE)
+    {
+      hash_move = (int8_t)xo_board_symmetry_squares
+          [xo_board_symmetry_inverse[frame]][entry.move];
+    }
+
+  uint8_t moves[XO_BOARD_SQUARES];
+  uint8_t move_count
+      = xo_game_cpu_order_moves (cpu, root, side, 0, hash_move, moves);
+
+  enum xo_bit_meaning_type other_side = side == XO_BIT_MEANING_SIDE_O
+                                            ? XO_BIT_MEANING_SIDE_X
+                                            : XO_BIT_MEANING_SIDE_O;
+  int32_t best_score = side == XO_BIT_MEANING_SIDE_O ? INT32_MIN : INT32_MAX;
+  int8_t best_square = XO_CPU_NO_MOVE;
+
+  /* Shared bound: alpha when O moves, beta when X moves */
+  int32_t bound = side == XO_BIT_MEANING_SIDE_O ? alpha : beta;
+
+#pragma omp parallel for num_threads(thread_count) schedule(dynamic, 1)
+  for (int i = 0; i < move_count; i++)
+    {
+      struct xo_cpu *worker = &workers[omp_get_thread_num ()];
+      struct xo_board_data board = *root;
+      int32_t window;
+      int32_t score;
+
+#pragma omp atomic read
+      window = bound;
+
+      /* A move already refuted the window: the others cannot matter */
+      if (side == XO_BIT_MEANING_SIDE_O ? window >= beta : window <= alpha)
+        {
+          continue;
+        }
+
+      worker->stats.nodes++;
+      if (xo_board_make_move (&board, side, moves[i]))
+        {
+          score = xo_game_cpu_score_final (&board,
+                                           side == XO_BIT_MEANING_SIDE_O
+                                               ? XO_WIN_STATE_O_WIN
+                                               : XO_WIN_STATE_X_WIN);
+        }
+      else if (xo_board_check_if_full (&board))
+        {
+          score = 0;
+        }
+      else
+        {
+          xo_game_cpu_child_hashes (hashes, side, moves[i],
+                                    worker->plies[1].hashes);
+          score = side == XO_BIT_MEANING_SIDE_O
+                      ? xo_game_cpu_minimax_eval (worker, &board, other_side,
+                                                  1, window, beta)
+                            .score
+                      : xo_game_cpu_minimax_eval (worker, &board, other_side,
+                                                  1, alpha, window)
+                            .score;
+        }
+
+#pragma omp critical(xo_cpu_root)
+      {
+        if (side == XO_BIT_MEANING_SIDE_O ? score > best_score
+                                          : score < best_score)
+          {
+            best_score = score;
+            best_square = (int8_t)moves[i];
+            if (side == XO_BIT_MEANING_SIDE_O ? score > bound : score < bound)
+              {
+#pragma omp atomic write
+                bound = score;
+              }
+          }
+      }
+    }
+
+  for (int i = 0; i < thread_count; i++)
+    {
+      xo_game_cpu_stats_add (&cpu->stats, &workers[i].stats);
+    }
+  cpu->stats.nodes++;
+
+  if (best_square != XO_CPU_NO_MOVE && !xo_game_cpu_stopped (cpu))
+    {
+      uint8_t empty_count = xo_board_empty_count (root);
+      enum xo_cpu_bound_type tt_bound = XO_CPU_BOUND_EXACT;
+      if (best_score <= alpha)
+        {
+          tt_bound = XO_CPU_BOUND_UPPER;
+        }
+      else if (best_score >= beta)
+        {
+          tt_bound = XO_CPU_BOUND_LOWER;
+        }
+      xo_game_cpu_tt_store (
+          cpu, key, best_score, tt_bound,
+          (int8_t)xo_board_symmetry_squares[frame][best_square],
+          best_score != 0
+              ? empty_count
+              : (uint8_t)SDL_min (cpu->max_ply, empty_count));
+    }
+
+  response.score = best_score;
+  response.has_move = best_square != XO_CPU_NO_MOVE;
+  response.move = (SDL_Point){ best_square % XO_BOARD_SIZE,
+                               best_square / XO_BOARD_SIZE };
+  return response;
+}
+
+/**
+ * Searches a position with Lazy SMP: all threads search the whole tree from
+ * the root, each with a differently rotated move order, and communicate only
+ * through the shared transposition table. Helpers mostly fill the table with
+ * results the other threads then hit. The first thread to finish gives the
+ * answer and stops the others.
+ * @param cpu
+ * @param root Position to search, which must not be over
+ * @param side Side to move
+ * @param alpha Window of the root, as in xo_game_cpu_minimax_eval
+ * @param beta
+ * @return
+ */
+static struct xo_cpu_response
+xo_game_cpu_search_lazy_smp (struct xo_cpu *cpu, struct xo_board_data *root,
+                             enum xo_bit_meaning_type side, int32_t alpha,
+                             int32_t beta)
+{
+  struct xo_cpu_response response = { 0 };
+  int thread_count = cpu->config.threads;
+  struct xo_cpu *workers = xo_game_cpu_fork (cpu, thread_count);
+  if (workers == NULL)
+    {
+      return response;
+    }
+
+  int stop = 0;
+  uint64_t hashes[XO_BOARD_SYMMETRIES];
+  xo_game_cpu_hash_board (root, side, hashes);
+
+#pragma omp parallel num_threads(thread_count)
+  {
+    int id = omp_get_thread_num ();
+    struct xo_cpu *worker = &workers[id];
+    struct xo_board_data board = *root;
+
+    worker->perturbation = (uint8_t)(id % XO_BOARD_SQUARES);
+    worker->stop = &stop;
+    memcpy (worker->plies[0].hashes, hashes, sizeof (hashes));
+
+    worker->stats.nodes++;
+    struct xo_cpu_response result
+        = xo_game_cpu_minimax_eval (worker, &board, side, 0, alpha, beta);
+
+#pragma omp critical(xo_cpu_lazy_smp)
+    {
+      if (stop == 0)
+        {
+          response = result;
+#pragma omp atomic write
+          stop = 1;
+          xo_log_debug (2, SDL_FALSE, "Lazy SMP thread %d finished first",
+                        id);
+        }
+    }
+  }
+
+  for (int i = 0; i < thread_count; i++)
+    {
+      xo_game_cpu_stats_add (&cpu->stats, &workers[i].stats);
+    }
+
+  return response;
+}
+
+/**
+ * Searches a position with Young Brothers Wait: at every node, the first
+ * move is searched alone, then the others become jobs on the deque of the
+ * thread (see xo_game_cpu_ybwc_split). Thread 0 searches the root, the other
+ * threads steal jobs until the root search is over.
+ * @param cpu
+ * @param root Position to search, which must not be over
+ * @param side Side to move
+ * @param alpha Window of the root, as in xo_game_cpu_minimax_eval
+ * @param beta
+ * @return The same score as xo_game_cpu_search_serial
+ */
+static struct xo_cpu_response
+xo_game_cpu_search_ybwc (struct xo_cpu *cpu, struct xo_board_data *root,
+                         enum xo_bit_meaning_type side, int32_t alpha,
+                         int32_t beta)
+{
+  struct xo_cpu_response response = { 0 };
+  int thread_count = cpu->config.threads;
+  struct xo_cpu_ybwc ybwc = { 0 };
+  struct xo_cpu *workers = xo_game_cpu_fork (cpu, thread_count);
+  ybwc.deques = (struct xo_cpu_deque *)xo_stack_alloc (
+      minimax_stack, (size_t)thread_count * sizeof (struct xo_cpu_deque));
+  if (workers == NULL || ybwc.deques == NULL)
+    {
+      return response;
+    }
+
+  ybwc.thread_count = thread_count;
+  for (int i = 0; i < thread_count; i++)
+    {
+      omp_init_lock (&ybwc.deques[i].lock);
+      workers[i].ybwc = &ybwc;
+    }
+
+#pragma omp parallel num_threads(thread_count)
+  {
+    struct xo_cpu *worker = &workers[omp_get_thread_num ()];
+
+    if (worker->id == 0)
+      {
+        struct xo_board_data board = *root;
+        xo_game_cpu_hash_board (&board, side, worker->plies[0].hashes);
+        worker->stats.nodes++;
+        response
+            = xo_game_cpu_minimax_eval (worker, &board, side, 0, alpha, beta);
+#pragma omp atomic write
+        ybwc.done = 1;
+      }
+    else
+      {
+        Uint64 idle_start = SDL_GetPerformanceCounter ();
+        int done = 0;
+        while (done == 0)
+          {
+            struct xo_cpu_job job;
+            if (xo_game_cpu_deque_steal (worker, NULL, &job))
+              {
+                worker->stats.idle_ticks
+                    += SDL_GetPerformanceCounter () - idle_start;
+                xo_game_cpu_ybwc_run (worker, &job);
+                idle_start = SDL_GetPerformanceCounter ();
+              }
+            else
+              {
+                xo_util_yield ();
+              }
+#pragma omp atomic read
+            done = ybwc.done;
+          }
+        worker->stats.idle_ticks += SDL_GetPerformanceCounter () - idle_start;
+      }
+  }
+
+  for (int i = 0; i < thread_count; i++)
+    {
+      omp_destroy_lock (&ybwc.deques[i].lock);
+      xo_game_cpu_stats_add (&cpu->stats, &workers[i].stats);
+    }
+
+  return response;
+}
+
+/**
+ * Takes a node from the MCTS pool and links it as the first child of parent.
+ * The node counts one iteration in progress: the one adding it.
+ * @param mcts
+ * @param parent XO_CPU_MCTS_NULL for a root
+ * @param move
+ * @param board Position after move, for its result and its moves
+ * @return The node, or XO_CPU_MCTS_NULL when the pool is empty
+ */
+static uint32_t
+xo_game_cpu_mcts_node_new (struct xo_cpu_mcts *mcts, uint32_t parent,
+                           int8_t move, struct xo_board_data *board)
+{
+  uint32_t index = mcts->free;
+  if (index == XO_CPU_MCTS_NULL)
+    {
+      return XO_CPU_MCTS_NULL;
+    }
+
+  struct xo_cpu_mcts_node *node = &mcts->nodes[index];
+  mcts->free = node->next;
+  mcts->used++;
+
+  node->parent = parent;
+  node->child = XO_CPU_MCTS_NULL;
+  node->next = XO_CPU_MCTS_NULL;
+  node->visits = XO_CPU_MCTS_VIRTUAL_LOSS;
+  node->reward = 0.0f;
+  node->move = move;
+  node->result = (int8_t)xo_board_test_if_final_state (board);
+  node->untried = node->result == XO_WIN_STATE_NONE
+                      ? (uint16_t)(~(board->x | board->o) & XO_BOARD_FULL_MASK)
+                      : 0;
+  if (parent != XO_CPU_MCTS_NULL)
+    {
+      /* Published last, so that threads walking the children only ever see
+       * a complete node */
+      node->next = mcts->nodes[parent].child;
+#pragma omp flush
+#pragma omp atomic write
+      mcts->nodes[parent].child = index;
+    }
+  return index;
+}
+/**
+ * Gives a subtree back to the MCTS pool, except for one of its subtrees.
+ * @param mcts
+ * @param index Root of the subtree
+ * @param keep Subtree to keep, or XO_CPU_MCTS_NULL
+ */
+static void
+xo_game_cpu_mcts_release (struct xo_cpu_mcts *mcts, uint32_t index,
+                          uint32_t keep)
+{
+  if (index == keep)
+    {
+      return;
+    }
+
+  uint32_t child = mcts->nodes[index].child;
+  while (child != XO_CPU_MCTS_NULL)
+    {
+      uint32_t next = mcts->nodes[child].next;
+      xo_game_cpu_mcts_release (mcts, child, keep);
+      child = next;
+    }
+
+  mcts->nodes[index].next = mcts->free;
+  mcts->free = index;
+  mcts->used--;
+}
+
+/**
+ * Makes the MCTS tree root the given position. When the position follows
+ * from the previous root by moves the tree holds (the CPU move, then the
+ * human move), that subtree and its statistics are kept and the rest of the
+ * tree is released. Otherwise the tree starts over.
+ * @param mcts
+ * @param board
+ * @param side Side to move
+ * @return SDL_FALSE when the pool is empty
+ */
+static SDL_bool
+xo_game_cpu_mcts_reroot (struct xo_cpu_mcts *mcts,
+                         const struct xo_board_data *board,
+                         enum xo_bit_meaning_type side)
+{
+  uint32_t node = mcts->root;
+  struct xo_board_data node_board = mcts->root_board;
+  enum xo_bit_meaning_type node_side = mcts->root_side;
+
+  /* Walks down the moves played since the last search */
+  while (node != XO_CPU_MCTS_NULL
+         && (node_board.x != board->x || node_board.o != board->o))
+    {
+      uint16_t added = node_side == XO_BIT_MEANING_SIDE_O
+                           ? (uint16_t)(board->o & ~node_board.o)
+                           : (uint16_t)(board->x & ~node_board.x);
+      uint32_t child = XO_CPU_MCTS_NULL;
+      if ((node_board.x & ~board->x) == 0 && (node_board.o & ~board->o) == 0)
+        {
+          child = mcts->nodes[node].child;
+          while (child != XO_CPU_MCTS_NULL
+                 && (added & (1u << mcts->nodes[child].move)) == 0)
+            {
+              child = mcts->nodes[child].next;
+            }
+        }
+      if (child != XO_CPU_MCTS_NULL)
+        {
+          xo_board_make_move (&node_board, node_side,
+                              (uint8_t)mcts->nodes[child].move);
+          node_side = node_side == XO_BIT_MEANING_SIDE_O
+                          ? XO_BIT_MEANING_SIDE_X
+                          : XO_BIT_MEANING_SIDE_O;
+        }
+      node = child;
+    }
+
+  if (node != XO_CPU_MCTS_NULL && node_side == side)
+    {
+      xo_log_debug (2, SDL_FALSE, "CPU MCTS keeps a subtree of %u visits",
+                    mcts->nodes[node].visits);
+      xo_game_cpu_mcts_release (mcts, mcts->root, node);
+      mcts->nodes[node].parent = XO_CPU_MCTS_NULL;
+      mcts->nodes[node].next = XO_CPU_MCTS_NULL;
+      mcts->root = node;
+      mcts->root_board = node_board;
+      return SDL_TRUE;
+    }
+
+  if (mcts->root != XO_CPU_MCTS_NULL)
+    {
+      xo_game_cpu_mcts_release (mcts, mcts->root, XO_CPU_MCTS_NULL);
+    }
+  mcts->root_board = *board;
+  xo_board_count_lines (&mcts->root_board);
+  mcts->root_side = side;
+  mcts->root = xo_game_cpu_mcts_node_new (mcts, XO_CPU_MCTS_NULL,
+                                          XO_CPU_NO_MOVE, &mcts->root_board);
+  return mcts->root != XO_CPU_MCTS_NULL;
+}
+
+/**
+ * Picks the child of an MCTS node with the best UCT value: the mean reward,
+ * plus an exploration bonus for children visited less than their siblings.
+ * @param mcts
+ * @param index A node with children
+ * @return
+ */
+static uint32_t
+xo_game_cpu_mcts_select (struct xo_cpu_mcts *mcts, uint32_t index)
+{
+  uint32_t parent_visits;
+  uint32_t child;
+#pragma omp atomic read
+  parent_visits = mcts->nodes[index].visits;
+#pragma omp atomic read
+  child = mcts->nodes[index].child;
+
+  double log_visits = log ((double)parent_visits);
+  double best_value = -1.0;
+  uint32_t best_child = child;
+
+  for (; child != XO_CPU_MCTS_NULL; child = mcts->nodes[child].next)
+    {
+      uint32_t visits;
+      float reward;
+#pragma omp atomic read
+      visits = mcts->nodes[child].visits;
+#pragma omp atomic read
+      reward = mcts->nodes[child].reward;
+
+      double value = (double)reward / visits
+                     + XO_CPU_MCTS_EXPLORATION * sqrt (log_visits / visits);
+      if (value > best_value)
+        {
+          best_value = value;
+          best_child = child;
+        }
+    }
+
+  return best_child;
+}
+
+/**
+ * Plays random moves until the game is over.
+ * @param board Position, which must not be over, and is played on
+ * @param side Side to move
+ * @param rng splitmix64 generator state
+ * @return The result of the game
+ */
+static enum xo_win_state_type
+xo_game_cpu_mcts_playout (struct xo_board_data *board,
+                          enum xo_bit_meaning_type side, uint64_t *rng)
+{
+  for (;;)
+    {
+      uint16_t empty = (uint16_t)(~(board->x | board->o) & XO_BOARD_FULL_MASK);
+      if (empty == 0)
+        {
+          return XO_WIN_STATE_TIE;
+        }
+      if (xo_board_make_move (board, side, xo_util_random_bit (empty, rng)))
+        {
+          return side == XO_BIT_MEANING_SIDE_O ? XO_WIN_STATE_O_WIN
+                                               : XO_WIN_STATE_X_WIN;
+        }
+      side = side == XO_BIT_MEANING_SIDE_O ? XO_BIT_MEANING_SIDE_X
+                                           : XO_BIT_MEANING_SIDE_O;
+    }
+}
+
+/**
+ * Runs one MCTS iteration: walks the tree down by UCT, adds one node,
+ * finishes the game with random moves and credits the result to the nodes
+ * it went through. Several threads can run iterations on the same tree.
+ * @param mcts A tree with a root
+ * @param rng splitmix64 generator state of the thread
+ */
+static void
+xo_game_cpu_mcts_iterate (struct xo_cpu_mcts *mcts, uint64_t *rng)
+{
+  struct xo_board_data board = mcts->root_board;
+  enum xo_bit_meaning_type side = mcts->root_side;
+  uint32_t index = mcts->root;
+  uint16_t untried;
+  uint32_t child;
+
+#pragma omp atomic update
+  mcts->nodes[index].visits += XO_CPU_MCTS_VIRTUAL_LOSS;
+
+  /* Selection, through the nodes whose moves all have a child */
+  for (;;)
+    {
+#pragma omp atomic read
+      untried = mcts->nodes[index].untried;
+#pragma omp atomic read
+      child = mcts->nodes[index].child;
+      if (untried != 0 || child == XO_CPU_MCTS_NULL)
+        {
+          break;
+        }
+
+      index = xo_game_cpu_mcts_select (mcts, index);
+#pragma omp atomic update
+      mcts->nodes[index].visits += XO_CPU_MCTS_VIRTUAL_LOSS;
+      xo_board_make_move (&board, side, (uint8_t)mcts->nodes[index].move);
+      side = side == XO_BIT_MEANING_SIDE_O ? XO_BIT_MEANING_SIDE_X
+                                           : XO_BIT_MEANING_SIDE_O;
+    }
+
+  /* Expansion of one untried move, while the pool lasts. Another thread may
+   * have taken the last untried move in the meantime. */
+  if (untried != 0)
+    {
+      omp_set_lock (&mcts->lock);
+      untried = mcts->nodes[index].untried;
+      if (untried != 0 && mcts->free != XO_CPU_MCTS_NULL)
+        {
+          uint8_t square = xo_util_random_bit (untried, rng);
+#pragma omp atomic write
+          mcts->nodes[index].untried = (uint16_t)(untried & ~(1u << square));
+          xo_board_make_move (&board, side, square);
+          index = xo_game_cpu_mcts_node_new (mcts, index, (int8_t)square,
+                                             &board);
+          side = side == XO_BIT_MEANING_SIDE_O ? XO_BIT_MEANING_SIDE_X
+                                               : XO_BIT_MEANING_SIDE_O;
+        }
+      omp_unset_lock (&mcts->lock);
+    }
+
+  /* Simulation */
+  enum xo_win_state_type result
+      = (enum xo_win_state_type)mcts->nodes[index].result;
+  if (result == XO_WIN_STATE_NONE)
+    {
+      result = xo_game_cpu_mcts_playout (&board, side, rng);
+    }
+
+  /* Backpropagation, for the side that played each move. The virtual loss
+   * becomes one real visit. */
+  enum xo_win_state_type mover_win = side == XO_BIT_MEANING_SIDE_O
+                                         ? XO_WIN_STATE_X_WIN
+                                         : XO_WIN_STATE_O_WIN;
+  for (; index != XO_CPU_MCTS_NULL; index = mcts->nodes[index].parent)
+    {
+      float reward = result == mover_win           ? 1.0f
+                     : result == XO_WIN_STATE_TIE ? 0.5f
+                                                  : 0.0f;
+#pragma omp atomic update
+      mcts->nodes[index].reward += reward;
+#pragma omp atomic update
+      mcts->nodes[index].visits += (uint32_t)(1 - XO_CPU_MCTS_VIRTUAL_LOSS);
+      mover_win = mover_win == XO_WIN_STATE_O_WIN ? XO_WIN_STATE_X_WIN
+                                                  : XO_WIN_STATE_O_WIN;
+    }
+}
+
+/**
+ * Turns the statistics of a root move into a response.
+ * @param side Side to move at the root
+ * @param move
+ * @param visits
+ * @param reward
+ * @return The move. The score is only an estimate, from the mean result of
+ * the move.
+ */
+static struct xo_cpu_response
+xo_game_cpu_mcts_response (enum xo_bit_meaning_type side, int8_t move,
+                           uint32_t visits, double reward)
+{
+  struct xo_cpu_response response = { 0 };
+  if (move == XO_CPU_NO_MOVE || visits == 0)
+    {
+      return response;
+    }
+
+  double mean = reward / visits;
+  int32_t win = side == XO_BIT_MEANING_SIDE_O ? XO_WIN_STATE_O_WIN
+                                              : XO_WIN_STATE_X_WIN;
+  response.score = mean > 0.75 ? win : mean < 0.25 ? -win : XO_WIN_STATE_TIE;
+  response.has_move = SDL_TRUE;
+  response.move = (SDL_Point){ move % XO_BOARD_SIZE, move / XO_BOARD_SIZE };
+  return response;
+}
+
+/**
+ * Searches a position with Monte Carlo tree search, the threads running
+ * iterations together on one tree. The tree is kept for the next CPU move
+ * (see xo_game_cpu_mcts_reroot).
+ * @param cpu
+ * @param board_data Position to search, which must not be over
+ * @param side Side to move
+ * @return The most visited move
+ */
+static struct xo_cpu_response
+xo_game_cpu_search_mcts (struct xo_cpu *cpu, struct xo_board_data *board_data,
+                         enum xo_bit_meaning_type side)
+{
+  struct xo_cpu_mcts *mcts = &cpu->mcts;
+  uint64_t playouts = 0;
+
+  if (mcts->nodes == NULL || !xo_game_cpu_mcts_reroot (mcts, board_data, side))
+    {
+      xo_log_error (SDL_FALSE, "CPU MCTS has no node left\n");
+      return (struct xo_cpu_response){ 0 };
+    }
+
+  uint64_t seed = xo_util_splitmix64 (&mcts->rng);
+  int iterations = (int)cpu->config.mcts_iterations;
+  if (cpu->node_limit != 0)
+    {
+      iterations = (int)SDL_min ((uint64_t)iterations, cpu->node_limit);
+    }
+
+#pragma omp parallel num_threads(cpu->config.threads) reduction(+ : playouts)
+  {
+    uint64_t rng = seed ^ (uint64_t)omp_get_thread_num ();
+
+#pragma omp for schedule(dynamic, 64)
+    for (int iteration = 0; iteration < iterations; iteration++)
+      {
+        if (!xo_game_cpu_past_deadline (cpu))
+          {
+            xo_game_cpu_mcts_iterate (mcts, &rng);
+            playouts++;
+          }
+      }
+  }
+  cpu->stats.nodes += playouts;
+
+  /* The most visited move is the most trusted one */
+  uint32_t best_child = XO_CPU_MCTS_NULL;
+  for (uint32_t child = mcts->nodes[mcts->root].child;
+       child != XO_CPU_MCTS_NULL; child = mcts->nodes[child].next)
+    {
+      if (best_child == XO_CPU_MCTS_NULL
+          || mcts->nodes[child].visits > mcts->nodes[best_child].visits)
+        {
+          best_child = child;
+        }
+    }
+
+  xo_log_debug (1, SDL_FALSE, "CPU MCTS: %u nodes of %u in use", mcts->used,
+                mcts->capacity);
+  if (best_child == XO_CPU_MCTS_NULL)
+    {
+      return (struct xo_cpu_response){ 0 };
+    }
+  return xo_game_cpu_mcts_response (side, mcts->nodes[best_child].move,
+                                    mcts->nodes[best_child].visits,
+                                    mcts->nodes[best_child].reward);
+}
+
+/**
+ * Searches a position with root-parallel Monte Carlo tree search: the pool is
+ * split among the threads, each thread grows a private tree from the root
+ * with its share of the iterations, and the visits and rewards of the root
+ * moves are added up at the end. The threads do not touch any shared node,
+ * but no tree is kept for the next CPU move.
+ * @param cpu
+ * @param board_data Position to search, which must not be over
+ * @param side Side to move
+ * @return The most visited move over all the trees
+ */
+static struct xo_cpu_response
+xo_game_cpu_search_mcts_root (struct xo_cpu *cpu,
+                              struct xo_board_data *board_data,
+                              enum xo_bit_meaning_type side)
+{
+  struct xo_cpu_mcts *mcts = &cpu->mcts;
+  int thread_count = cpu->config.threads;
+  uint32_t visits[XO_BOARD_SQUARES] = { 0 };
+  double rewards[XO_BOARD_SQUARES] = { 0 };
+  uint64_t playouts = 0;
+
+  uint32_t slice = mcts->capacity / (uint32_t)thread_count;
+  if (mcts->nodes == NULL || slice == 0)
+    {
+      xo_log_error (SDL_FALSE, "CPU MCTS has no node left\n");
+      return (struct xo_cpu_response){ 0 };
+    }
+
+  uint64_t seed = xo_util_splitmix64 (&mcts->rng);
+
+#pragma omp parallel num_threads(thread_count) reduction(+ : playouts)
+  {
+    int id = omp_get_thread_num ();
+    uint64_t rng = seed ^ (uint64_t)id;
+    uint32_t total = cpu->node_limit != 0
+                         ? (uint32_t)SDL_min (cpu->config.mcts_iterations,
+                                              cpu->node_limit)
+                         : cpu->config.mcts_iterations;
+    uint32_t iterations = total / (uint32_t)thread_count
+                          + ((uint32_t)id < total % (uint32_t)thread_count);
+    struct xo_cpu_mcts tree;
+
+    xo_game_cpu_mcts_reset (&tree, &mcts->nodes[(uint32_t)id * slice], slice);
+    omp_init_lock (&tree.lock);
+    if (xo_game_cpu_mcts_reroot (&tree, board_data, side))
+      {
+        for (uint32_t iteration = 0;
+             iteration < iterations && !xo_game_cpu_past_deadline (cpu);
+             iteration++)
+          {
+            xo_game_cpu_mcts_iterate (&tree, &rng);
+            playouts++;
+          }
+
+#pragma omp critical(xo_cpu_mcts_root)
+        {
+          for (uint32_t child = tree.nodes[tree.root].child;
+               child != XO_CPU_MCTS_NULL; child = tree.nodes[child].next)
+            {
+              visits[tree.nodes[child].move] += tree.nodes[child].visits;
+              rewards[tree.nodes[child].move] += tree.nodes[child].reward;
+            }
+        }
+      }
+    omp_destroy_lock (&tree.lock);
+  }
+  cpu->stats.nodes += playouts;
+
+  /* The slices were reused as they were: the whole pool is free again */
+  xo_game_cpu_mcts_reset (mcts, mcts->nodes, mcts->capacity);
+
+  int8_t best_move = XO_CPU_NO_MOVE;
+  for (int8_t move = 0; move < XO_BOARD_SQUARES; move++)
+    {
+      if (visits[move] > 0
+          && (best_move == XO_CPU_NO_MOVE || visits[move] > visits[best_move]))
+        {
+          best_move = move;
+        }
+    }
+
+  return xo_game_cpu_mcts_response (
+      side, best_move, best_move == XO_CPU_NO_MOVE ? 0 : visits[best_move],
+      best_move == XO_CPU_NO_MOVE ? 0.0 : rewards[best_move]);
+}
+
+/**
+ * Runs the minimax engine selected in the configuration once.
+ * @param cpu
+ * @param root Position to search, which must not be over
+ * @param side Side to move
+ * @param alpha Window of the root, as in xo_game_cpu_minimax_eval
+ * @param beta
+ * @return
+ */
+static struct xo_cpu_response
+xo_game_cpu_search_engine (struct xo_cpu *cpu, struct xo_board_data *root,
+                           enum xo_bit_meaning_type side, int32_t alpha,
+                           int32_t beta)
+{
+  struct xo_cpu_response response;
+
+  size_t mark = xo_stack_mark (minimax_stack);
+  switch (cpu->config.engine)
+    {
+    case XO_CPU_ENGINE_ROOT_SPLIT:
+      response
+          = xo_game_cpu_search_root_split (cpu, root, side, alpha, beta);
+      break;
+    case XO_CPU_ENGINE_LAZY_SMP:
+      response = xo_game_cpu_search_lazy_smp (cpu, root, side, alpha, beta);
+      break;
+    case XO_CPU_ENGINE_YBWC:
+      response = xo_game_cpu_search_ybwc (cpu, root, side, alpha, beta);
+      break;
+    /* The MCTS engines are run by xo_game_cpu_search, and never get here */
+    case XO_CPU_ENGINE_MCTS:
+    case XO_CPU_ENGINE_MCTS_ROOT:
+    case XO_CPU_ENGINE_SERIAL:
+    default:
+      response = xo_game_cpu_search_serial (cpu, root, side, alpha, beta);
+      break;
+    }
+  xo_stack_rewind (minimax_stack, mark);
+
+  return response;
+}
+
+/**
+ * Searches a position for the given side to move, with the engine selected
+ * in the configuration. The representative of the position is searched, and
+ * the move is mapped back to board_data.
+ * @param cpu
+ * @param board_data
+ * @param side Side to move
+ * @return
+ */
+static struct xo_cpu_response
+xo_game_cpu_search (struct xo_cpu *cpu, struct xo_board_data *board_data,
+                    enum xo_bit_meaning_type side)
+{
+  struct xo_cpu_response response = { 0 };
+
+  /* Checks if the game is over (someone won or the board is full) */
+  enum xo_win_state_type board_win_state
+      = xo_board_test_if_final_state (board_data);
+  if (board_win_state != XO_WIN_STATE_NONE)
+    {
+      response.score = xo_game_cpu_score_final (board_data, board_win_state);
+      response.has_move = SDL_FALSE;
+      return response;
+    }
+
+  Uint64 start = SDL_GetPerformanceCounter ();
+  struct xo_cpu_budget budget = { 0 };
+  SDL_bool b_budget
+      = cpu->config.time_limit_ms != 0 || cpu->config.node_limit != 0;
+  if (cpu->config.time_limit_ms != 0)
+    {
+      budget.deadline = start
+                        + cpu->config.time_limit_ms
+                              * SDL_GetPerformanceFrequency () / 1000;
+    }
+  cpu->node_limit = cpu->config.node_limit;
+
+  /* The MCTS tree follows the game itself, so it is not canonicalized */
+  if (cpu->config.engine == XO_CPU_ENGINE_MCTS
+      || cpu->config.engine == XO_CPU_ENGINE_MCTS_ROOT)
+    {
+      cpu->budget = b_budget ? &budget : NULL;
+      response = cpu->config.engine == XO_CPU_ENGINE_MCTS
+                     ? xo_game_cpu_search_mcts (cpu, board_data, side)
+                     : xo_game_cpu_search_mcts_root (cpu, board_data, side);
+      cpu->budget = NULL;
+      cpu->stats.search_ticks += SDL_GetPerformanceCounter () - start;
+      return response;
+    }
+
+  struct xo_board_data canonical;
+  uint8_t transform = xo_board_canonicalize (board_data, &canonical);
+  uint8_t empty_count = xo_board_empty_count (&canonical);
+  xo_game_cpu_age_heuristics (cpu);
+
+  /* Iterative deepening, under a budget: each iteration searches one ply
+   * deeper, starting with the moves the previous ones stored in the
+   * transposition table. When the budget runs out, the iteration in progress
+   * is thrown away. The first iteration is cheap and always completes, so
+   * that there is a move to play. Without a budget, the tree is searched
+   * whole at once. */
+  uint8_t completed_depth = 0;
+  for (uint8_t max_ply = b_budget ? 1 : empty_count; max_ply <= empty_count;
+       max_ply++)
+    {
+      struct xo_cpu_response iteration_response;
+      cpu->max_ply = max_ply;
+      cpu->budget = b_budget && max_ply > 1 ? &budget : NULL;
+
+      /* Aspiration: a narrow window around the score of the last depth,
+       * searched again with the whole window if the score falls outside */
+      int32_t alpha = -XO_CPU_SCORE_INFINITY;
+      int32_t beta = XO_CPU_SCORE_INFINITY;
+      if (cpu->config.b_pvs && completed_depth > 0)
+        {
+          alpha = response.score - XO_CPU_ASPIRATION_WINDOW;
+          beta = response.score + XO_CPU_ASPIRATION_WINDOW;
+        }
+      iteration_response
+          = xo_game_cpu_search_engine (cpu, &canonical, side, alpha, beta);
+      if ((iteration_response.score <= alpha
+           || iteration_response.score >= beta)
+          && budget.aborted == 0)
+        {
+          cpu->stats.researches++;
+          iteration_response = xo_game_cpu_search_engine (
+              cpu, &canonical, side, -XO_CPU_SCORE_INFINITY,
+              XO_CPU_SCORE_INFINITY);
+        }
+
+      if (budget.aborted != 0)
+        {
+          break;
+        }
+      response = iteration_response;
+      completed_depth = max_ply;
+
+      /* A win or a loss found at this depth holds at any depth */
+      if (response.score != 0)
+        {
+          break;
+        }
+    }
+  cpu->budget = NULL;
+  cpu->stats.search_ticks += SDL_GetPerformanceCounter () - start;
+  xo_log_debug (2, SDL_FALSE, "CPU completed depth %u of %u", completed_depth,
+                empty_count);
+
+  if (response.has_move)
+    {
+      uint8_t square
+          = xo_board_symmetry_squares[xo_board_symmetry_inverse[transform]]
+                                     [response.move.y * XO_BOARD_SIZE
+                                      + response.move.x];
+      response.move
+          = (SDL_Point){ square % XO_BOARD_SIZE, square / XO_BOARD_SIZE };
+    }
+
+  return response;
+}
+
+#ifndef XO_GEN_TABLE
+/**
+ * Answers a position from the generated perfect-play table, without any
+ * search.
+ * @param board_data
+ * @return The same response the search gives for the side to move
+ */
+static struct xo_cpu_response
+xo_game_cpu_table_probe (struct xo_board_data *board_data)
+{
+  const struct xo_table_entry *entry = &xo_table[xo_board_index (board_data)];
+  struct xo_cpu_response response;
+
+  response.score = entry->score;
+  response.has_move = entry->move != XO_CPU_NO_MOVE;
+  response.move = (SDL_Point){ entry->move % XO_BOARD_SIZE,
+                               entry->move / XO_BOARD_SIZE };
+  return response;
+}
+
+/**
+ * Answers a position from the tablebase, without any search: the move is the
+ * first one, in the static order, that wins on the spot or else leads to the
+ * best value.
+ * @param tablebase 3x3 tablebase
+ * @param board_data
+ * @param side Side to move
+ * @return Response with the score of the position for O, in
+ * xo_win_state_type values, and no move if the tablebase does not hold the
+ * position
+ */
+static struct xo_cpu_response
+xo_game_cpu_tablebase_probe (const struct xo_tablebase *tablebase,
+                             struct xo_board_data *board_data,
+                             enum xo_bit_meaning_type side)
+{
+  struct xo_cpu_response response = { 0 };
+  uint8_t cells[XO_BOARD_SQUARES];
+  for (uint8_t square = 0; square < XO_BOARD_SQUARES; square++)
+    {
+      cells[square] = (board_data->x >> square) & 1   ? 1
+                      : (board_data->o >> square) & 1 ? 2
+                                                      : 0;
+    }
+
+  /* Values of the moves, for the side to move, from worst to best */
+  static const enum xo_tablebase_value_type move_values[]
+      = { XO_TABLEBASE_WIN, XO_TABLEBASE_DRAW, XO_TABLEBASE_LOSS };
+  int best = -1;
+  for (uint8_t i = 0; i < XO_BOARD_SQUARES && best < 3; i++)
+    {
+      uint8_t square = xo_cpu_move_order_static[i];
+      if (cells[square] != 0)
+        {
+          continue;
+        }
+
+      struct xo_board_data child = *board_data;
+      xo_board_bit_set_at (&child, side, square % XO_BOARD_SIZE,
+                           square / XO_BOARD_SIZE);
+      int rank = xo_board_validate_win_conditions_for (&child, side) ? 3 : 0;
+
+      cells[square] = side == XO_BIT_MEANING_SIDE_X ? 1 : 2;
+      enum xo_tablebase_value_type value
+          = xo_tablebase_probe (tablebase, cells);
+      cells[square] = 0;
+      if (value == XO_TABLEBASE_UNKNOWN)
+        {
+          return (struct xo_cpu_response){ 0 };
+        }
+      for (int j = 0; rank == 0 && j < 3; j++)
+        {
+          rank = move_values[j] == value ? j : rank;
+        }
+
+      if (rank > best)
+        {
+          best = rank;
+          response.has_move = SDL_TRUE;
+          response.move = (SDL_Point){ square % XO_BOARD_SIZE,
+                                       square / XO_BOARD_SIZE };
+        }
+    }
+
+  /* 0 is a loss for the side to move, 1 a draw and 2 or 3 a win */
+  int32_t score = best < 0 ? 0 : SDL_min (best, 2) - 1;
+  response.score = side == XO_BIT_MEANING_SIDE_O ? score : -score;
+  return response;
+}
+
+/**
+ * Searches a Qubic position with alpha-beta, principal variation search and
+ * the shared transposition table. A side that can complete a line wins at
+ * once, and a side facing two lines it cannot both block loses. With a single
+ * threat, the block is the only move searched. The other moves are tried
+ * from the table move, the killer move of the ply, then the cells on most
+ * lines, from a cell that depends on the thread for Lazy SMP helpers. Wins
+ * score XO_QUBIC_SCORE_WIN plus the cells left empty, so that the scores
+ * depend on the position only, as the table needs.
+ * @param search The position is search->board
+ * @param side Side to move
+ * @param depth Plies left before the position is evaluated
+ * @param alpha
+ * @param beta
+ * @param ply Plies played since the root
+ * @param hash Zobrist hash of the position
+ * @param move Receives the best move
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_qubic_negamax (struct xo_qubic_search *search,
+                           enum xo_bit_meaning_type side, uint8_t depth,
+                           int32_t alpha, int32_t beta, uint8_t ply,
+                           uint64_t hash, int8_t *move)
+{
+  struct xo_cpu *cpu = search->cpu;
+  struct xo_qubic_board *board = &search->board;
+  uint64_t *own = side == XO_BIT_MEANING_SIDE_X ? &board->x : &board->o;
+  uint64_t other = side == XO_BIT_MEANING_SIDE_X ? board->o : board->x;
+  enum xo_bit_meaning_type other_side = side == XO_BIT_MEANING_SIDE_X
+                                            ? XO_BIT_MEANING_SIDE_O
+                                            : XO_BIT_MEANING_SIDE_X;
+  int32_t empty_count = XO_QUBIC_CELLS - board->count;
+
+  cpu->stats.nodes++;
+  if (xo_game_cpu_stopped (cpu))
+    {
+      return 0;
+    }
+
+  uint64_t wins = xo_qubic_completions (*own, other);
+  if (wins != 0)
+    {
+      *move = (int8_t)xo_qubic_first_cell (wins);
+      return XO_QUBIC_SCORE_WIN + empty_count - 1;
+    }
+  if (empty_count == 0)
+    {
+      return 0;
+    }
+  uint64_t threats = xo_qubic_completions (other, *own);
+  if ((threats & (threats - 1)) != 0)
+    {
+      *move = (int8_t)xo_qubic_first_cell (threats);
+      return -(XO_QUBIC_SCORE_WIN + empty_count - 2);
+    }
+  if (depth == 0)
+    {
+      return xo_qubic_evaluate (*own, other);
+    }
+
+  int8_t hash_move = XO_CPU_NO_MOVE;
+  struct xo_cpu_tt_entry entry;
+  if (xo_game_cpu_tt_probe (cpu, hash, &entry))
+    {
+      hash_move = (int8_t)entry.move;
+      if (ply > 0 && entry.depth >= depth
+          && (entry.bound == XO_CPU_BOUND_EXACT
+              || (entry.bound == XO_CPU_BOUND_LOWER && entry.score >= beta)
+              || (entry.bound == XO_CPU_BOUND_UPPER && entry.score <= alpha)))
+        {
+          *move = (int8_t)entry.move;
+          return entry.score;
+        }
+    }
+
+  /* The moves, best candidates first, each once */
+  uint64_t candidates = threats != 0 ? threats : ~(board->x | board->o);
+  int8_t moves[XO_QUBIC_CELLS];
+  uint8_t move_count = 0;
+  int8_t firsts[2] = { hash_move, search->killers[ply] };
+  for (uint8_t i = 0; i < 2; i++)
+    {
+      if (firsts[i] != XO_CPU_NO_MOVE && (candidates >> firsts[i] & 1) != 0)
+        {
+          moves[move_count++] = firsts[i];
+          candidates &= ~(1ull << firsts[i]);
+        }
+    }
+  for (uint8_t i = 0; i < XO_QUBIC_CELLS; i++)
+    {
+      uint8_t cell
+          = xo_qubic_order[(i + cpu->perturbation * 7) % XO_QUBIC_CELLS];
+      if ((candidates >> cell & 1) != 0)
+        {
+          moves[move_count++] = (int8_t)cell;
+        }
+    }
+
+  int32_t alpha_start = alpha;
+  int32_t best_score = -XO_CPU_SCORE_INFINITY;
+  int8_t best_move = XO_CPU_NO_MOVE;
+  for (uint8_t i = 0; i < move_count; i++)
+    {
+      uint8_t cell = (uint8_t)moves[i];
+      uint64_t child_hash = hash ^ xo_qubic_zobrist_side
+                            ^ xo_qubic_zobrist[side == XO_BIT_MEANING_SIDE_O]
+                                              [cell];
+      int8_t reply = XO_CPU_NO_MOVE;
+      int32_t score;
+
+      *own |= 1ull << cell;
+      board->count++;
+      if (i > 0 && cpu->config.b_pvs)
+        {
+          score = -xo_game_cpu_qubic_negamax (
+              search, other_side, (uint8_t)(depth - 1), -alpha - 1, -alpha,
+              (uint8_t)(ply + 1), child_hash, &reply);
+          if (score > alpha && score < beta)
+            {
+              score = -xo_game_cpu_qubic_negamax (
+                  search, other_side, (uint8_t)(depth - 1), -beta, -alpha,
+                  (uint8_t)(ply + 1), child_hash, &reply);
+            }
+        }
+      else
+        {
+          score = -xo_game_cpu_qubic_negamax (
+              search, other_side, (uint8_t)(depth - 1), -beta, -alpha,
+              (uint8_t)(ply + 1), child_hash, &reply);
+        }
+      board->count--;
+      *own &= ~(1ull << cell);
+      if (xo_game_cpu_stopped (cpu))
+        {
+          return 0;
+        }
+
+      if (score > best_score)
+        {
+          best_score = score;
+          best_move = (int8_t)cell;
+        }
+      alpha = SDL_max (alpha, score);
+      if (alpha >= beta)
+        {
+          search->killers[ply] = (int8_t)cell;
+          cpu->stats.cutoffs++;
+          cpu->stats.first_move_cutoffs += i == 0;
+          break;
+        }
+    }
+
+  xo_game_cpu_tt_store (cpu, hash, best_score,
+                        best_score <= alpha_start ? XO_CPU_BOUND_UPPER
+                        : best_score >= beta      ? XO_CPU_BOUND_LOWER
+                                                  : XO_CPU_BOUND_EXACT,
+                        best_move, depth);
+  *move = best_move;
+  return best_score;
+}
+
+/**
+ * Searches a Qubic position to a fixed depth on one thread, see
+ * xo_cpu_variant.
+ * @param cpu
+ * @param root The xo_qubic_board to search, which must not be over
+ * @param side Side to move
+ * @param depth
+ * @param move Receives the best move, as a cell
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_qubic_search_root (struct xo_cpu *cpu, const void *root,
+                               enum xo_bit_meaning_type side, uint8_t depth,
+                               int16_t *move)
+{
+  struct xo_qubic_search search;
+  int8_t cell = XO_CPU_NO_MOVE;
+  search.cpu = cpu;
+  search.board = *(const struct xo_qubic_board *)root;
+  memset (search.killers, XO_CPU_NO_MOVE, sizeof (search.killers));
+  int32_t score = xo_game_cpu_qubic_negamax (
+      &search, side, depth, -XO_CPU_SCORE_INFINITY, XO_CPU_SCORE_INFINITY, 0,
+      xo_qubic_hash (&search.board, side), &cell);
+  *move = cell;
+  return score;
+}
+
+static const struct xo_cpu_variant xo_cpu_variant_qubic
+    = { "qubic", XO_QUBIC_SCORE_WIN, xo_game_cpu_qubic_search_root };
+
+/**
+ * Searches a position of a game variant to a fixed depth, on one thread with
+ * the serial engine, and otherwise with Lazy SMP on every thread: the threads
+ * share the transposition table and start their move order at different
+ * cells, and the first one to finish gives the answer.
+ * @param cpu
+ * @param variant
+ * @param root Position to search, which must not be over
+ * @param side Side to move
+ * @param depth
+ * @param move Receives the best move
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_variant_search_depth (struct xo_cpu *cpu,
+                                  const struct xo_cpu_variant *variant,
+                                  const void *root,
+                                  enum xo_bit_meaning_type side, uint8_t depth,
+                                  int16_t *move)
+{
+  int thread_count = cpu->config.engine == XO_CPU_ENGINE_SERIAL
+                         ? 1
+                         : cpu->config.threads;
+  size_t mark = xo_stack_mark (minimax_stack);
+  struct xo_cpu *workers
+      = thread_count > 1 ? xo_game_cpu_fork (cpu, thread_count) : NULL;
+  int32_t score = 0;
+
+  if (workers == NULL)
+    {
+      xo_stack_rewind (minimax_stack, mark);
+      return variant->search (cpu, root, side, depth, move);
+    }
+
+  int stop = 0;
+#pragma omp parallel num_threads(thread_count)
+  {
+    int id = omp_get_thread_num ();
+    int16_t result_move = XO_CPU_NO_MOVE;
+    workers[id].perturbation = (uint8_t)id;
+    workers[id].stop = &stop;
+
+    int32_t result
+        = variant->search (&workers[id], root, side, depth, &result_move);
+
+#pragma omp critical(xo_cpu_variant_lazy_smp)
+    {
+      if (stop == 0)
+        {
+          score = result;
+          *move = result_move;
+#pragma omp atomic write
+          stop = 1;
+        }
+    }
+  }
+
+  for (int i = 0; i < thread_count; i++)
+    {
+      xo_game_cpu_stats_add (&cpu->stats, &workers[i].stats);
+    }
+  xo_stack_rewind (minimax_stack, mark);
+  return score;
+}
+
+/**
+ * Finds the CPU move in a position of a game variant, searching one ply
+ * deeper at a time until the budget is spent (XO_MNK_CPU_TIME_MS without
+ * --time-limit, as the trees are far too large to search whole) or the game
+ * is solved. The first ply is always searched in full, so that there is a
+ * move to play.
+ * @param cpu
+ * @param variant
+ * @param root Position to search, which must not be over
+ * @param side Side to move
+ * @param max_depth Most plies the game can last
+ * @param start Performance counter value when the budget of the move began
+ * @param move Receives the best move
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_variant_search (struct xo_cpu *cpu,
+                            const struct xo_cpu_variant *variant,
+                            const void *root, enum xo_bit_meaning_type side,
+                            uint8_t max_depth, Uint64 start, int16_t *move)
+{
+  struct xo_cpu_budget budget = { 0 };
+  budget.deadline = start
+                    + SDL_GetPerformanceFrequency ()
+                          * (cpu->config.time_limit_ms != 0
+                                 ? cpu->config.time_limit_ms
+                                 : XO_MNK_CPU_TIME_MS)
+                          / 1000;
+  cpu->node_limit = cpu->config.node_limit;
+
+  int32_t score = 0;
+  *move = XO_CPU_NO_MOVE;
+  for (uint8_t depth = 1; depth <= max_depth; depth++)
+    {
+      int16_t depth_move = XO_CPU_NO_MOVE;
+      cpu->budget = depth > 1 ? &budget : NULL;
+      int32_t depth_score = xo_game_cpu_variant_search_depth (
+          cpu, variant, root, side, depth, &depth_move);
+      if (budget.aborted != 0)
+        {
+          break;
+        }
+      score = depth_score;
+      *move = depth_move;
+      xo_log_debug (2, SDL_FALSE,
+                    "CPU %s depth %u: score %d, %" SDL_PRIu64 " nodes",
+                    variant->name, depth, score, cpu->stats.nodes);
+      if (SDL_abs (score) >= variant->score_win)
+        {
+          break;
+        }
+    }
+  cpu->budget = NULL;
+  cpu->stats.search_ticks += SDL_GetPerformanceCounter () - start;
+  return score;
+}
+
+/**
+ * Finds the CPU move of a Qubic game.
+ * @param cpu
+ * @param root
+ * @param side Side to move
+ * @return The move, as a square of the 8x8 board, with its score from the
+ * point of view of O
+ */
+static struct xo_cpu_response
+xo_game_cpu_qubic_search (struct xo_cpu *cpu,
+                          const struct xo_qubic_board *root,
+                          enum xo_bit_meaning_type side)
+{
+  struct xo_cpu_response response = { 0 };
+  if (xo_qubic_final_state (root) != XO_WIN_STATE_NONE)
+    {
+      return response;
+    }
+
+  int16_t move;
+  int32_t score = xo_game_cpu_variant_search (
+      cpu, &xo_cpu_variant_qubic, root, side,
+      (uint8_t)(XO_QUBIC_CELLS - root->count), SDL_GetPerformanceCounter (),
+      &move);
+  response.has_move = move != XO_CPU_NO_MOVE;
+  if (response.has_move)
+    {
+      response.move = xo_qubic_cell_square ((uint8_t)move);
+    }
+  response.score = side == XO_BIT_MEANING_SIDE_O ? score : -score;
+  return response;
+}
+
+/**
+ * Searches an ultimate tic-tac-toe position with alpha-beta, principal
+ * variation search and the shared transposition table, as
+ * xo_game_cpu_qubic_negamax does for Qubic. A side that can win a local board
+ * completing one of its global lines wins at once; both tests are lookups in
+ * xo_ultimate_completions. The moves are tried from the table move, the
+ * killer move of the ply, then the moves that win a local board, the others,
+ * and last the moves that let the other side pick any local board.
+ * @param search
+ * @param board Position to search
+ * @param side Side to move
+ * @param depth Plies left before the position is evaluated
+ * @param alpha
+ * @param beta
+ * @param ply Plies played since the root
+ * @param hash Zobrist hash of the position
+ * @param move Receives the best move
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_ultimate_negamax (struct xo_ultimate_search *search,
+                              const struct xo_ultimate_board *board,
+                              enum xo_bit_meaning_type side, uint8_t depth,
+                              int32_t alpha, int32_t beta, uint8_t ply,
+                              uint64_t hash, int8_t *move)
+{
+  struct xo_cpu *cpu = search->cpu;
+  uint8_t side_index = side == XO_BIT_MEANING_SIDE_O;
+  uint16_t won
+      = side == XO_BIT_MEANING_SIDE_X ? board->global.x : board->global.o;
+  enum xo_bit_meaning_type other_side = side == XO_BIT_MEANING_SIDE_X
+                                            ? XO_BIT_MEANING_SIDE_O
+                                            : XO_BIT_MEANING_SIDE_X;
+  int32_t empty_count = XO_ULTIMATE_CELLS - board->count;
+
+  cpu->stats.nodes++;
+  if (xo_game_cpu_stopped (cpu))
+    {
+      return 0;
+    }
+
+  uint16_t open = xo_ultimate_open_boards (board);
+  if (open == 0)
+    {
+      return 0;
+    }
+  for (uint16_t deciding = open & xo_ultimate_completions[won];
+       deciding != 0; deciding &= (uint16_t)(deciding - 1))
+    {
+      uint8_t local = xo_ultimate_first_square (deciding);
+      const struct xo_board_data *data = &board->locals[local];
+      uint16_t own = side == XO_BIT_MEANING_SIDE_X ? data->x : data->o;
+      uint16_t wins
+          = (uint16_t)(xo_ultimate_completions[own] & ~(data->x | data->o));
+      if (wins != 0)
+        {
+          *move = (int8_t)(local * XO_BOARD_SQUARES
+                           + xo_ultimate_first_square (wins));
+          return XO_ULTIMATE_SCORE_WIN + empty_count - 1;
+        }
+    }
+  if (depth == 0)
+    {
+      return xo_ultimate_evaluate (board, side);
+    }
+
+  int8_t hash_move = XO_CPU_NO_MOVE;
+  struct xo_cpu_tt_entry entry;
+  if (xo_game_cpu_tt_probe (cpu, hash, &entry))
+    {
+      hash_move = (int8_t)entry.move;
+      if (ply > 0 && entry.depth >= depth
+          && (entry.bound == XO_CPU_BOUND_EXACT
+              || (entry.bound == XO_CPU_BOUND_LOWER && entry.score >= beta)
+              || (entry.bound == XO_CPU_BOUND_UPPER && entry.score <= alpha)))
+        {
+          *move = (int8_t)entry.move;
+          return entry.score;
+        }
+    }
+
+  /* The moves in three groups, after the table and killer moves */
+  int8_t moves[XO_ULTIMATE_CELLS];
+  uint8_t move_count = 0;
+  int8_t firsts[2] = { hash_move, search->killers[ply] };
+  for (uint8_t i = 0; i < 2; i++)
+    {
+      int8_t first = firsts[i];
+      if (first != XO_CPU_NO_MOVE && (i == 0 || first != firsts[0]))
+        {
+          const struct xo_board_data *data
+              = &board->locals[first / XO_BOARD_SQUARES];
+          if ((open >> (first / XO_BOARD_SQUARES) & 1) != 0
+              && ((data->x | data->o) >> (first % XO_BOARD_SQUARES) & 1) == 0)
+            {
+              moves[move_count++] = first;
+            }
+        }
+    }
+  uint8_t first_count = move_count;
+  for (uint8_t group = 0; group < 3; group++)
+    {
+      for (uint16_t locals = open; locals != 0;
+           locals &= (uint16_t)(locals - 1))
+        {
+          uint8_t local = xo_ultimate_first_square (locals);
+          const struct xo_board_data *data = &board->locals[local];
+          uint16_t own = side == XO_BIT_MEANING_SIDE_X ? data->x : data->o;
+          uint16_t empty
+              = (uint16_t)(~(data->x | data->o) & XO_BOARD_FULL_MASK);
+          uint16_t local_wins = xo_ultimate_completions[own] & empty;
+          uint16_t squares
+              = group == 0 ? local_wins
+                : group == 1
+                    ? (uint16_t)(empty & ~local_wins & ~board->closed)
+                    : (uint16_t)(empty & ~local_wins & board->closed);
+          for (; squares != 0; squares &= (uint16_t)(squares - 1))
+            {
+              int8_t cell = (int8_t)(local * XO_BOARD_SQUARES
+                                     + xo_ultimate_first_square (squares));
+              if (cell != moves[0] && (first_count < 2 || cell != moves[1]))
+                {
+                  moves[move_count++] = cell;
+                }
+            }
+        }
+    }
+
+  /* Lazy SMP helpers rotate the moves after the first */
+  if (cpu->perturbation != 0 && move_count > first_count + 1)
+    {
+      int8_t rotated[XO_ULTIMATE_CELLS];
+      uint8_t rest = (uint8_t)(move_count - first_count);
+      for (uint8_t i = 0; i < rest; i++)
+        {
+          rotated[i] = moves[first_count + (i + cpu->perturbation) % rest];
+        }
+      memcpy (&moves[first_count], rotated, rest);
+    }
+
+  int32_t alpha_start = alpha;
+  int32_t best_score = -XO_CPU_SCORE_INFINITY;
+  int8_t best_move = XO_CPU_NO_MOVE;
+  for (uint8_t i = 0; i < move_count; i++)
+    {
+      struct xo_ultimate_board child = *board;
+      xo_ultimate_play (&child, side, (uint8_t)moves[i]);
+      uint64_t child_hash = hash ^ xo_ultimate_zobrist_side
+                            ^ xo_ultimate_zobrist[side_index][moves[i]]
+                            ^ xo_ultimate_zobrist_next[board->next + 1]
+                            ^ xo_ultimate_zobrist_next[child.next + 1];
+      int8_t reply = XO_CPU_NO_MOVE;
+      int32_t score;
+
+      if (i > 0 && cpu->config.b_pvs)
+        {
+          score = -xo_game_cpu_ultimate_negamax (
+              search, &child, other_side, (uint8_t)(depth - 1), -alpha - 1,
+              -alpha, (uint8_t)(ply + 1), child_hash, &reply);
+          if (score > alpha && score < beta)
+            {
+              score = -xo_game_cpu_ultimate_negamax (
+                  search, &child, other_side, (uint8_t)(depth - 1), -beta,
+                  -alpha, (uint8_t)(ply + 1), child_hash, &reply);
+            }
+        }
+      else
+        {
+          score = -xo_game_cpu_ultimate_negamax (
+              search, &child, other_side, (uint8_t)(depth - 1), -beta,
+              -alpha, (uint8_t)(ply + 1), child_hash, &reply);
+        }
+      if (xo_game_cpu_stopped (cpu))
+        {
+          return 0;
+        }
+
+      if (score > best_score)
+        {
+          best_score = score;
+          best_move = moves[i];
+        }
+      alpha = SDL_max (alpha, score);
+      if (alpha >= beta)
+        {
+          search->killers[ply] = moves[i];
+          cpu->stats.cutoffs++;
+          cpu->stats.first_move_cutoffs += i == 0;
+          break;
+        }
+    }
+
+  xo_game_cpu_tt_store (cpu, hash, best_score,
+                        best_score <= alpha_start ? XO_CPU_BOUND_UPPER
+                        : best_score >= beta      ? XO_CPU_BOUND_LOWER
+                                                  : XO_CPU_BOUND_EXACT,
+                        best_move, depth);
+  *move = best_move;
+  return best_score;
+}
+
+/**
+ * Searches an ultimate tic-tac-toe position to a fixed depth on one thread,
+ * see xo_cpu_variant.
+ * @param cpu
+ * @param root The xo_ultimate_board to search, which must not be over
+ * @param side Side to move
+ * @param depth
+ * @param move Receives the best move, as local board * 9 + square
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_ultimate_search_root (struct xo_cpu *cpu, const void *root,
+                                  enum xo_bit_meaning_type side,
+                                  uint8_t depth, int16_t *move)
+{
+  const struct xo_ultimate_board *board
+      = (const struct xo_ultimate_board *)root;
+  struct xo_ultimate_search search;
+  int8_t cell = XO_CPU_NO_MOVE;
+  search.cpu = cpu;
+  memset (search.killers, XO_CPU_NO_MOVE, sizeof (search.killers));
+  int32_t score = xo_game_cpu_ultimate_negamax (
+      &search, board, side, depth, -XO_CPU_SCORE_INFINITY,
+      XO_CPU_SCORE_INFINITY, 0, xo_ultimate_hash (board, side), &cell);
+  *move = cell;
+  return score;
+}
+
+static const struct xo_cpu_variant xo_cpu_variant_ultimate
+    = { "ultimate", XO_ULTIMATE_SCORE_WIN, xo_game_cpu_ultimate_search_root };
+
+/**
+ * Finds the CPU move of an ultimate tic-tac-toe game.
+ * @param cpu
+ * @param root
+ * @param side Side to move
+ * @return The move, as a square of the 9x9 board, with its score from the
+ * point of view of O
+ */
+static struct xo_cpu_response
+xo_game_cpu_ultimate_search (struct xo_cpu *cpu,
+                             const struct xo_ultimate_board *root,
+                             enum xo_bit_meaning_type side)
+{
+  struct xo_cpu_response response = { 0 };
+  if (xo_ultimate_final_state (root) != XO_WIN_STATE_NONE)
+    {
+      return response;
+    }
+
+  int16_t move;
+  int32_t score = xo_game_cpu_variant_search (
+      cpu, &xo_cpu_variant_ultimate, root, side,
+      (uint8_t)(XO_ULTIMATE_CELLS - root->count), SDL_GetPerformanceCounter (),
+      &move);
+  response.has_move = move != XO_CPU_NO_MOVE;
+  if (response.has_move)
+    {
+      response.move = xo_ultimate_move_square ((uint8_t)move);
+    }
+  response.score = side == XO_BIT_MEANING_SIDE_O ? score : -score;
+  return response;
+}
+
+/**
+ * Searches a gravity position with alpha-beta, principal variation search
+ * and the shared transposition table, as xo_game_cpu_qubic_negamax does for
+ * Qubic. The moves are columns, whose landing cells are the bits of
+ * board->heights; the wins and threats are the line completions of
+ * xo_mnk_completions on those cells alone. A side facing two threats loses,
+ * and with one, the block is the only move searched. The other columns are
+ * tried from the table move, the killer move of the ply, then from the
+ * center out, from a column that depends on the thread for Lazy SMP helpers.
+ * @param search The position is search->board
+ * @param side Side to move
+ * @param depth Plies left before the position is evaluated
+ * @param alpha
+ * @param beta
+ * @param ply Plies played since the root
+ * @param hash Zobrist hash of the position
+ * @param move Receives the best move, as a column
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_gravity_negamax (struct xo_gravity_search *search,
+                             enum xo_bit_meaning_type side, uint8_t depth,
+                             int32_t alpha, int32_t beta, uint16_t ply,
+                             uint64_t hash, int8_t *move)
+{
+  struct xo_cpu *cpu = search->cpu;
+  struct xo_gravity_board *board = &search->board;
+  const struct xo_mnk_geometry *geometry = board->geometry;
+  uint8_t word_count = geometry->word_count;
+  const struct xo_mnk_bits *own
+      = side == XO_BIT_MEANING_SIDE_X ? &board->pieces.x : &board->pieces.o;
+  const struct xo_mnk_bits *other
+      = side == XO_BIT_MEANING_SIDE_X ? &board->pieces.o : &board->pieces.x;
+  enum xo_bit_meaning_type other_side = side == XO_BIT_MEANING_SIDE_X
+                                            ? XO_BIT_MEANING_SIDE_O
+                                            : XO_BIT_MEANING_SIDE_X;
+  int32_t empty_count = geometry->cells - board->pieces.count;
+
+  cpu->stats.nodes++;
+  if (xo_game_cpu_stopped (cpu))
+    {
+      return 0;
+    }
+
+  struct xo_mnk_bits empty;
+  struct xo_mnk_bits wins;
+  struct xo_mnk_bits threats;
+  for (uint8_t word = 0; word < word_count; word++)
+    {
+      empty.words[word] = geometry->full.words[word]
+                          & ~(board->pieces.x.words[word]
+                              | board->pieces.o.words[word]);
+    }
+  xo_mnk_completions (geometry, own, &empty, 1, &wins);
+  for (uint8_t word = 0; word < word_count; word++)
+    {
+      wins.words[word] &= board->heights.words[word];
+    }
+  uint16_t bit = xo_mnk_bits_next (&wins, 0, word_count);
+  if (bit != XO_MNK_BITS)
+    {
+      *move = (int8_t)(bit % geometry->stride);
+      return XO_GRAVITY_SCORE_WIN + empty_count - 1;
+    }
+  if (empty_count == 0)
+    {
+      return 0;
+    }
+  xo_mnk_completions (geometry, other, &empty, 1, &threats);
+  for (uint8_t word = 0; word < word_count; word++)
+    {
+      threats.words[word] &= board->heights.words[word];
+    }
+  uint16_t threat_count = xo_mnk_bits_count (&threats, word_count);
+  if (threat_count >= 2)
+    {
+      *move = (int8_t)(xo_mnk_bits_next (&threats, 0, word_count)
+                       % geometry->stride);
+      return -(XO_GRAVITY_SCORE_WIN + empty_count - 2);
+    }
+  if (depth == 0)
+    {
+      return xo_mnk_evaluate (geometry, own, other);
+    }
+
+  int8_t hash_move = XO_CPU_NO_MOVE;
+  struct xo_cpu_tt_entry entry;
+  if (xo_game_cpu_tt_probe (cpu, hash, &entry))
+    {
+      hash_move = (int8_t)entry.move;
+      if (ply > 0 && entry.depth >= depth
+          && (entry.bound == XO_CPU_BOUND_EXACT
+              || (entry.bound == XO_CPU_BOUND_LOWER && entry.score >= beta)
+              || (entry.bound == XO_CPU_BOUND_UPPER && entry.score <= alpha)))
+        {
+          *move = (int8_t)entry.move;
+          return entry.score;
+        }
+    }
+
+  /* The landing cell of each column that may be played, each taken once */
+  const struct xo_mnk_bits *candidates
+      = threat_count != 0 ? &threats : &board->heights;
+  uint16_t landings[XO_MNK_MAX_SIZE];
+  for (uint8_t col = 0; col < geometry->width; col++)
+    {
+      landings[col] = XO_MNK_BITS;
+    }
+  for (bit = xo_mnk_bits_next (candidates, 0, word_count); bit != XO_MNK_BITS;
+       bit = xo_mnk_bits_next (candidates, (uint16_t)(bit + 1), word_count))
+    {
+      landings[bit % geometry->stride] = bit;
+    }
+
+  int8_t moves[XO_MNK_MAX_SIZE];
+  uint8_t move_count = 0;
+  int8_t firsts[2] = { hash_move, search->killers[ply] };
+  for (uint8_t i = 0; i < 2; i++)
+    {
+      if (firsts[i] >= 0 && firsts[i] < geometry->width
+          && landings[firsts[i]] != XO_MNK_BITS)
+        {
+          moves[move_count++] = firsts[i];
+        }
+    }
+  uint8_t first_count = move_count;
+  for (uint8_t i = 0; i < geometry->width; i++)
+    {
+      /* Center column, then right and left of it in turn */
+      uint8_t turn = (uint8_t)((i + cpu->perturbation) % geometry->width);
+      int col = (geometry->width - 1) / 2
+                + ((turn & 1) != 0 ? (turn + 1) / 2 : -(turn / 2));
+      if (landings[col] != XO_MNK_BITS
+          && (first_count < 1 || col != moves[0])
+          && (first_count < 2 || col != moves[1]))
+        {
+          moves[move_count++] = (int8_t)col;
+        }
+    }
+
+  int32_t alpha_start = alpha;
+  int32_t best_score = -XO_CPU_SCORE_INFINITY;
+  int8_t best_move = XO_CPU_NO_MOVE;
+  for (uint8_t i = 0; i < move_count; i++)
+    {
+      uint16_t landing = landings[moves[i]];
+      uint64_t child_hash
+          = hash ^ xo_mnk_zobrist_side
+            ^ xo_mnk_zobrist[side == XO_BIT_MEANING_SIDE_O][landing];
+      int8_t reply = XO_CPU_NO_MOVE;
+      int32_t score;
+
+      xo_gravity_toggle (board, side, landing);
+      board->pieces.count++;
+      if (i > 0 && cpu->config.b_pvs)
+        {
+          score = -xo_game_cpu_gravity_negamax (
+              search, other_side, (uint8_t)(depth - 1), -alpha - 1, -alpha,
+              (uint16_t)(ply + 1), child_hash, &reply);
+          if (score > alpha && score < beta)
+            {
+              score = -xo_game_cpu_gravity_negamax (
+                  search, other_side, (uint8_t)(depth - 1), -beta, -alpha,
+                  (uint16_t)(ply + 1), child_hash, &reply);
+            }
+        }
+      else
+        {
+          score = -xo_game_cpu_gravity_negamax (
+              search, other_side, (uint8_t)(depth - 1), -beta, -alpha,
+              (uint16_t)(ply + 1), child_hash, &reply);
+        }
+      board->pieces.count--;
+      xo_gravity_toggle (board, side, landing);
+      if (xo_game_cpu_stopped (cpu))
+        {
+          return 0;
+        }
+
+      if (score > best_score)
+        {
+          best_score = score;
+          best_move = moves[i];
+        }
+      alpha = SDL_max (alpha, score);
+      if (alpha >= beta)
+        {
+          search->killers[ply] = moves[i];
+          cpu->stats.cutoffs++;
+          cpu->stats.first_move_cutoffs += i == 0;
+          break;
+        }
+    }
+
+  xo_game_cpu_tt_store (cpu, hash, best_score,
+                        best_score <= alpha_start ? XO_CPU_BOUND_UPPER
+                        : best_score >= beta      ? XO_CPU_BOUND_LOWER
+                                                  : XO_CPU_BOUND_EXACT,
+                        best_move, depth);
+  *move = best_move;
+  return best_score;
+}
+
+/**
+ * Searches a gravity position to a fixed depth on one thread, see
+ * xo_cpu_variant.
+ * @param cpu
+ * @param root The xo_gravity_board to search, which must not be over
+ * @param side Side to move
+ * @param depth
+ * @param move Receives the best move, as a column
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_gravity_search_root (struct xo_cpu *cpu, const void *root,
+                                 enum xo_bit_meaning_type side, uint8_t depth,
+                                 int16_t *move)
+{
+  struct xo_gravity_search search;
+  int8_t col = XO_CPU_NO_MOVE;
+  search.cpu = cpu;
+  search.board = *(const struct xo_gravity_board *)root;
+  memset (search.killers, XO_CPU_NO_MOVE, sizeof (search.killers));
+  int32_t score = xo_game_cpu_gravity_negamax (
+      &search, side, depth, -XO_CPU_SCORE_INFINITY, XO_CPU_SCORE_INFINITY, 0,
+      xo_mnk_hash (search.board.geometry, &search.board.pieces, side), &col);
+  *move = col;
+  return score;
+}
+
+static const struct xo_cpu_variant xo_cpu_variant_gravity
+    = { "gravity", XO_GRAVITY_SCORE_WIN, xo_game_cpu_gravity_search_root };
+
+/**
+ * Finds the CPU move of a gravity game.
+ * @param cpu
+ * @param root
+ * @param side Side to move
+ * @return The move, as the square the piece lands on, with its score from
+ * the point of view of O
+ */
+static struct xo_cpu_response
+xo_game_cpu_gravity_search (struct xo_cpu *cpu,
+                            const struct xo_gravity_board *root,
+                            enum xo_bit_meaning_type side)
+{
+  struct xo_cpu_response response = { 0 };
+  if (xo_mnk_board_final_state (root->geometry, &root->pieces)
+      != XO_WIN_STATE_NONE)
+    {
+      return response;
+    }
+
+  int16_t move;
+  int32_t score = xo_game_cpu_variant_search (
+      cpu, &xo_cpu_variant_gravity, root, side,
+      (uint8_t)SDL_min (root->geometry->cells - root->pieces.count,
+                        UINT8_MAX),
+      SDL_GetPerformanceCounter (), &move);
+  response.has_move = move != XO_CPU_NO_MOVE;
+  if (response.has_move)
+    {
+      response.move = (SDL_Point){
+        move, xo_gravity_drop_row (root->geometry, &root->pieces, move)
+      };
+    }
+  response.score = side == XO_BIT_MEANING_SIDE_O ? score : -score;
+  return response;
+}
+
+/**
+ * Searches an m,n,k position to a fixed depth on one thread, see
+ * xo_cpu_variant and xo_mnk_search_node.
+ * @param cpu
+ * @param root The xo_mnk_search holding the position, which must not be
+ * over, its geometry and its kernel
+ * @param side Side to move
+ * @param depth
+ * @param move Receives the best move, as a cell bit
+ * @return The score for the side to move
+ */
+static int32_t
+xo_game_cpu_mnk_search_root (struct xo_cpu *cpu, const void *root,
+                             enum xo_bit_meaning_type side, uint8_t depth,
+                             int16_t *move)
+{
+  struct xo_mnk_search search = *(const struct xo_mnk_search *)root;
+  uint16_t bit = XO_MNK_BITS;
+  search.cpu = cpu;
+  memset (search.killers, 0xFF, sizeof (search.killers));
+  int32_t score = search.kernel->negamax (
+      &search, side, depth, -XO_CPU_SCORE_INFINITY, XO_CPU_SCORE_INFINITY, 0,
+      xo_mnk_hash (search.geometry, &search.board, side), &bit);
+  *move = bit != XO_MNK_BITS ? (int16_t)bit : XO_CPU_NO_MOVE;
+  return score;
+}
+
+static const struct xo_cpu_variant xo_cpu_variant_mnk
+    = { "m,n,k", XO_MNK_SCORE_WIN, xo_game_cpu_mnk_search_root };
+
+static SDL_bool xo_tss_cpu_move (struct xo_cpu *cpu,
+                                 const struct xo_mnk_geometry *geometry,
+                                 const struct xo_mnk_board *board,
+                                 enum xo_bit_meaning_type side,
+                                 int32_t *score, uint16_t *move);
+
+/**
+ * Finds the CPU move on a board other than 3x3. The first move of a game is
+ * the center, without a search. Then a threat-space search plays or blocks
+ * a forced win, see xo_tss_cpu_move, and when it finds none the alpha-beta
+ * search gets the rest of the budget.
+ * @param cpu
+ * @param geometry
+ * @param board
+ * @param side Side to move
+ * @return The move, with its score from the point of view of O
+ */
+static struct xo_cpu_response
+xo_game_cpu_mnk_search (struct xo_cpu *cpu,
+                        const struct xo_mnk_geometry *geometry,
+                        const struct xo_mnk_board *board,
+                        enum xo_bit_meaning_type side)
+{
+  struct xo_cpu_response response = { 0 };
+  if (xo_mnk_board_final_state (geometry, board) != XO_WIN_STATE_NONE)
+    {
+      return response;
+    }
+  if (board->count == 0)
+    {
+      response.has_move = SDL_TRUE;
+      response.move = (SDL_Point){ (geometry->width - 1) / 2,
+                                   (geometry->height - 1) / 2 };
+      return response;
+    }
+
+  Uint64 start = SDL_GetPerformanceCounter ();
+  int32_t score = 0;
+  uint16_t bit = 0;
+  if (xo_tss_cpu_move (cpu, geometry, board, side, &score, &bit))
+    {
+      response.has_move = SDL_TRUE;
+      response.move
+          = (SDL_Point){ bit % geometry->stride, bit / geometry->stride };
+      response.score = side == XO_BIT_MEANING_SIDE_O ? score : -score;
+      return response;
+    }
+
+  struct xo_mnk_search root;
+  root.cpu = NULL;
+  root.geometry = geometry;
+  root.kernel = xo_mnk_kernel_find (geometry);
+  root.tablebase = cpu->tablebase;
+  root.board = *board;
+  int16_t move;
+  score = xo_game_cpu_variant_search (
+      cpu, &xo_cpu_variant_mnk, &root, side,
+      (uint8_t)SDL_min (geometry->cells - board->count, UINT8_MAX), start,
+      &move);
+  response.has_move = move != XO_CPU_NO_MOVE;
+  if (response.has_move)
+    {
+      response.move = (SDL_Point){ move % geometry->stride,
+                                   move / geometry->stride };
+    }
+  response.score = side == XO_BIT_MEANING_SIDE_O ? score : -score;
+  return response;
+}
+
+/**
+ * Plays the AI move, thus returning a result from the perfect-play table or
+ * from a minimax evaluation. Boards other than 3x3 are searched by
+ * xo_game_cpu_mnk_search, Qubic by xo_game_cpu_qubic_search, ultimate
+ * tic-tac-toe by xo_game_cpu_ultimate_search and gravity boards by
+ * xo_game_cpu_gravity_search.
+ * @param current_board the last board
+ * @return
+ */
+static SDL_Point
+xo_game_cpu_find_next_play (struct xo_app *app)
+{
+  xo_log_debug (1, SDL_FALSE, "CPU begins looking for move. . .");
+
+  struct xo_cpu *cpu = &app->game->cpu;
+  const struct xo_mnk_geometry *geometry = &app->game->geometry;
+  cpu->stats = (struct xo_cpu_stats){ 0 };
+
+  if (app->game->variant == XO_VARIANT_QUBIC)
+    {
+      struct xo_qubic_board board;
+      xo_qubic_from_mnk (geometry, &app->game->board->pieces, &board);
+      struct xo_cpu_response response
+          = xo_game_cpu_qubic_search (cpu, &board, XO_BIT_MEANING_SIDE_O);
+      xo_log_debug (1, SDL_FALSE,
+                    "CPU Qubic search returned move %d, %d with score %d, "
+                    "%" SDL_PRIu64 " nodes",
+                    response.move.x, response.move.y, response.score,
+                    cpu->stats.nodes);
+      return response.move;
+    }
+  if (app->game->variant == XO_VARIANT_ULTIMATE)
+    {
+      struct xo_ultimate_board board;
+      xo_ultimate_from_mnk (geometry, &app->game->board->pieces,
+                            app->game->last_move, &board);
+      struct xo_cpu_response response
+          = xo_game_cpu_ultimate_search (cpu, &board, XO_BIT_MEANING_SIDE_O);
+      xo_log_debug (1, SDL_FALSE,
+                    "CPU ultimate search returned move %d, %d with score %d, "
+                    "%" SDL_PRIu64 " nodes",
+                    response.move.x, response.move.y, response.score,
+                    cpu->stats.nodes);
+      return response.move;
+    }
+  if (app->game->variant == XO_VARIANT_GRAVITY)
+    {
+      struct xo_gravity_board board;
+      xo_gravity_from_mnk (geometry, &app->game->board->pieces, &board);
+      struct xo_cpu_response response
+          = xo_game_cpu_gravity_search (cpu, &board, XO_BIT_MEANING_SIDE_O);
+      xo_log_debug (1, SDL_FALSE,
+                    "CPU gravity search returned move %d, %d with score %d, "
+                    "%" SDL_PRIu64 " nodes",
+                    response.move.x, response.move.y, response.score,
+                    cpu->stats.nodes);
+      return response.move;
+    }
+  if (!xo_mnk_is_tic_tac_toe (geometry))
+    {
+      struct xo_cpu_response response = xo_game_cpu_mnk_search (
+          cpu, geometry, &app->game->board->pieces, XO_BIT_MEANING_SIDE_O);
+      xo_log_debug (1, SDL_FALSE,
+                    "CPU m,n,k search returned move %d, %d with score %d, "
+                    "%" SDL_PRIu64 " nodes",
+                    response.move.x, response.move.y, response.score,
+                    cpu->stats.nodes);
+      return response.move;
+    }
+
+  /* The 3x3 engine and its tables work on xo_board_data */
+  struct xo_board_data board_data;
+  xo_mnk_board_to_data (geometry, &app->game->board->pieces, &board_data);
+
+  if (cpu->config.table_mode == XO_CPU_TABLE_ON)
+    {
+      struct xo_cpu_response response
+          = xo_game_cpu_table_probe (&board_data);
+      xo_log_debug (1, SDL_FALSE,
+                    "CPU table returned move %d, %d with score %d",
+                    response.move.x, response.move.y, response.score);
+      return response.move;
+    }
+  if (cpu->config.table_mode == XO_CPU_TABLE_TABLEBASE)
+    {
+      struct xo_cpu_response response = xo_game_cpu_tablebase_probe (
+          cpu->tablebase, &board_data, XO_BIT_MEANING_SIDE_O);
+      if (response.has_move)
+        {
+          xo_log_debug (1, SDL_FALSE,
+                        "CPU tablebase returned move %d, %d with value %d",
+                        response.move.x, response.move.y, response.score);
+          return response.move;
+        }
+      /* Positions the tablebase does not hold are searched */
+    }
+
+  struct xo_cpu_response response
+      = xo_game_cpu_search (cpu, &board_data, XO_BIT_MEANING_SIDE_O);
+
+  xo_log_debug (1, SDL_FALSE, "CPU brain returned move %d, %d with score %d",
+                response.move.x, response.move.y, response.score);
+  xo_log_debug (1, SDL_FALSE,
+                "CPU searched %" SDL_PRIu64 " nodes, with %" SDL_PRIu64
+                " re-searches",
+                cpu->stats.nodes, cpu->stats.researches);
+  xo_log_debug (1, SDL_FALSE,
+                "CPU cutoffs: %" SDL_PRIu64 ", %.1f%% on the first move",
+                cpu->stats.cutoffs,
+                cpu->stats.cutoffs > 0 ? 100.0
+                                             * (double)cpu->stats
+                                                   .first_move_cutoffs
+                                             / (double)cpu->stats.cutoffs
+                                       : 0.0);
+  xo_log_debug (1, SDL_FALSE,
+                "CPU transposition table: %" SDL_PRIu64 " probes, %" SDL_PRIu64
+                " hits, %" SDL_PRIu64 " stores",
+                cpu->stats.tt_probes, cpu->stats.tt_hits,
+                cpu->stats.tt_stores);
+  if (cpu->config.engine == XO_CPU_ENGINE_YBWC)
+    {
+      xo_log_debug (1, SDL_FALSE,
+                    "CPU YBWC: %" SDL_PRIu64 " steals, %.3f ms idle",
+                    cpu->stats.steals,
+                    (double)cpu->stats.idle_ticks * 1000.0
+                        / (double)SDL_GetPerformanceFrequency ());
+    }
+  if ((cpu->config.engine == XO_CPU_ENGINE_MCTS
+       || cpu->config.engine == XO_CPU_ENGINE_MCTS_ROOT)
+      && cpu->stats.search_ticks > 0)
+    {
+      xo_log_debug (1, SDL_FALSE, "CPU MCTS: %.0f playouts/s on %d threads",
+                    (double)cpu->stats.nodes
+                        * (double)SDL_GetPerformanceFrequency ()
+                        / (double)cpu->stats.search_ticks,
+                    cpu->config.threads);
+    }
+
+  if (cpu->config.table_mode == XO_CPU_TABLE_VERIFY)
+    {
+      struct xo_cpu_response expected
+          = xo_game_cpu_table_probe (&board_data);
+      if (expected.score != response.score)
+        {
+          xo_log_error (SDL_FALSE,
+                        "CPU table disagrees with the search: score %d "
+                        "instead of %d\n",
+                        expected.score, response.score);
+        }
+    }
+
+  return response.move;
+}
+
+/**
+ * Times the search of a game variant to a fixed depth, with the serial engine
+ * and with Lazy SMP, and prints the nodes and the node rate of each.
+ * @param cpu Configuration to run the engines with
+ * @param variant
+ * @param root Position to search
+ * @param side Side to move
+ * @param depth
+ */
+static void
+xo_game_cpu_bench_variant (struct xo_cpu *cpu,
+                           const struct xo_cpu_variant *variant,
+                           const void *root, enum xo_bit_meaning_type side,
+                           uint8_t depth)
+{
+  static const enum xo_cpu_engine_type engines[]
+      = { XO_CPU_ENGINE_SERIAL, XO_CPU_ENGINE_LAZY_SMP };
+  enum xo_cpu_engine_type saved_engine = cpu->config.engine;
+  double frequency = (double)SDL_GetPerformanceFrequency ();
+  double serial_ms = 0.0;
+
+  for (int i = 0; i < 2; i++)
+    {
+      int16_t move = XO_CPU_NO_MOVE;
+      cpu->config.engine = engines[i];
+      cpu->stats = (struct xo_cpu_stats){ 0 };
+      xo_game_cpu_tt_clear (cpu);
+
+      Uint64 start = SDL_GetPerformanceCounter ();
+      for (uint8_t iteration = 1; iteration <= depth; iteration++)
+        {
+          xo_game_cpu_variant_search_depth (cpu, variant, root, side,
+                                            iteration, &move);
+        }
+      double ms = (double)(SDL_GetPerformanceCounter () - start) * 1000.0
+                  / frequency;
+      if (i == 0)
+        {
+          serial_ms = ms;
+        }
+      printf ("%-8s %-8s %8d %6u %12" SDL_PRIu64 " %10.3f %12.0f %8.2f\n",
+              variant->name, i == 0 ? "serial" : "lazy",
+              i == 0 ? 1 : cpu->config.threads, depth, cpu->stats.nodes, ms,
+              ms > 0.0 ? (double)cpu->stats.nodes * 1000.0 / ms : 0.0,
+              ms > 0.0 ? serial_ms / ms : 0.0);
+    }
+
+  cpu->config.engine = saved_engine;
+  xo_game_cpu_tt_clear (cpu);
+}
+
+/**
+ * Times the search of each game variant from its empty board, see
+ * xo_game_cpu_bench_variant.
+ * @param cpu Configuration to run the engines with
+ * @return 0 for success
+ */
+static int32_t
+xo_game_cpu_bench_variants (struct xo_cpu *cpu)
+{
+  struct xo_qubic_board qubic = { 0 };
+  struct xo_ultimate_board ultimate = { 0 };
+  ultimate.next = XO_CPU_NO_MOVE;
+  struct xo_mnk_geometry geometry;
+  struct xo_gravity_board gravity;
+  struct xo_mnk_geometry mnk_geometry;
+  struct xo_mnk_search mnk = { 0 };
+  if (xo_mnk_geometry_init (&geometry, XO_GRAVITY_BENCH_WIDTH,
+                            XO_GRAVITY_BENCH_HEIGHT, XO_GRAVITY_BENCH_K)
+          != 0
+      || xo_mnk_geometry_init (&mnk_geometry, XO_MNK_BENCH_WIDTH,
+                               XO_MNK_BENCH_HEIGHT, XO_MNK_BENCH_K)
+             != 0)
+    {
+      return 1;
+    }
+  xo_gravity_from_mnk (&geometry, &(struct xo_mnk_board){ 0 }, &gravity);
+  mnk.geometry = &mnk_geometry;
+  mnk.kernel = xo_mnk_kernel_find (&mnk_geometry);
+
+  printf ("\n%-8s %-8s %8s %6s %12s %10s %12s %8s\n", "variant", "engine",
+          "threads", "depth", "nodes", "ms", "nodes/s", "speedup");
+  xo_game_cpu_bench_variant (cpu, &xo_cpu_variant_qubic, &qubic,
+                             XO_BIT_MEANING_SIDE_X, XO_QUBIC_BENCH_DEPTH);
+  xo_game_cpu_bench_variant (cpu, &xo_cpu_variant_ultimate, &ultimate,
+                             XO_BIT_MEANING_SIDE_X, XO_ULTIMATE_BENCH_DEPTH);
+  xo_game_cpu_bench_variant (cpu, &xo_cpu_variant_gravity, &gravity,
+                             XO_BIT_MEANING_SIDE_X, XO_GRAVITY_BENCH_DEPTH);
+  xo_game_cpu_bench_variant (cpu, &xo_cpu_variant_mnk, &mnk,
+                             XO_BIT_MEANING_SIDE_X, XO_MNK_BENCH_DEPTH);
+  return 0;
+}
+
+/**
+ * Times every search engine on the same positions, with an empty
+ * transposition table for each search, and prints the time, the nodes, the
+ * speedup over the serial engine and the YBWC work-stealing counters, then
+ * the game variants with xo_game_cpu_bench_variants and the m,n,k kernels
+ * with xo_mnk_kernel_bench. Debug logging stays off from then on, as the
+ * program quits after the bench.
+ * @param cpu Configuration to run the engines with
+ * @return 0 for success
+ */
+static int32_t
+xo_game_cpu_bench (struct xo_cpu *cpu)
+{
+  static const char *engine_names[] = { "serial", "root", "lazy", "ybwc" };
+  /* The empty board, then the corner, edge and center openings */
+  static const struct xo_board_data positions[]
+      = { { 0, 0, 0, 0 }, { 0x001, 0, 0, 0 }, { 0x002, 0, 0, 0 },
+          { 0x010, 0, 0, 0 } };
+  const int repeat = 100;
+  const size_t position_count = sizeof (positions) / sizeof (positions[0]);
+  enum xo_cpu_engine_type saved_engine = cpu->config.engine;
+  double serial_ms = 0.0;
+
+  xo_debug_log = XO_DEBUG_LOG_NONE;
+  printf ("%-8s %8s %10s %12s %10s %8s %8s %8s %10s\n", "engine",
+          "threads", "ms", "nodes", "research", "1st cut", "speedup",
+          "steals", "idle ms");
+
+  for (int engine = XO_CPU_ENGINE_SERIAL; engine <= XO_CPU_ENGINE_YBWC;
+       engine++)
+    {
+      cpu->config.engine = (enum xo_cpu_engine_type)engine;
+      cpu->stats = (struct xo_cpu_stats){ 0 };
+      Uint64 ticks = 0;
+
+      for (int i = 0; i < repeat; i++)
+        {
+          for (size_t p = 0; p < position_count; p++)
+            {
+              struct xo_board_data board_data = positions[p];
+              xo_board_count_lines (&board_data);
+              xo_game_cpu_tt_clear (cpu);
+
+              Uint64 start = SDL_GetPerformanceCounter ();
+              xo_game_cpu_search (cpu, &board_data,
+                                  board_data.x != 0 ? XO_BIT_MEANING_SIDE_O
+                                                    : XO_BIT_MEANING_SIDE_X);
+              ticks += SDL_GetPerformanceCounter () - start;
+            }
+        }
+
+      double frequency = (double)SDL_GetPerformanceFrequency ();
+      double ms = (double)ticks * 1000.0 / frequency;
+      if (engine == XO_CPU_ENGINE_SERIAL)
+        {
+          serial_ms = ms;
+        }
+      printf ("%-8s %8d %10.3f %12" SDL_PRIu64 " %10" SDL_PRIu64
+              " %7.1f%% %8.2f %8" SDL_PRIu64 " %10.3f\n",
+              engine_names[engine],
+              engine == XO_CPU_ENGINE_SERIAL ? 1 : cpu->config.threads, ms,
+              cpu->stats.nodes, cpu->stats.researches,
+              cpu->stats.cutoffs > 0
+                  ? 100.0 * (double)cpu->stats.first_move_cutoffs
+                        / (double)cpu->stats.cutoffs
+                  : 0.0,
+              ms > 0.0 ? serial_ms / ms : 0.0,
+              cpu->stats.steals,
+              (double)cpu->stats.idle_ticks * 1000.0 / frequency);
+    }
+
+  /* MCTS playout rates, from one thread up, when the pool was allocated */
+  if (cpu->mcts.nodes != NULL)
+    {
+      static const char *mcts_names[] = { "mcts", "mcts-root" };
+      int saved_threads = cpu->config.threads;
+      struct xo_board_data empty = { 0 };
+
+      printf ("\n%-10s %8s %14s %8s\n", "engine", "threads", "playouts/s",
+              "speedup");
+      for (int engine = XO_CPU_ENGINE_MCTS; engine <= XO_CPU_ENGINE_MCTS_ROOT;
+           engine++)
+        {
+          double single_rate = 0.0;
+          cpu->config.engine = (enum xo_cpu_engine_type)engine;
+          for (int threads = 1; threads <= saved_threads;
+               threads = threads < saved_threads
+                             ? SDL_min (threads * 2, saved_threads)
+                             : threads + 1)
+            {
+              cpu->config.threads = threads;
+              cpu->stats = (struct xo_cpu_stats){ 0 };
+              xo_game_cpu_mcts_reset (&cpu->mcts, cpu->mcts.nodes,
+                                      cpu->mcts.capacity);
+              xo_game_cpu_search (cpu, &empty, XO_BIT_MEANING_SIDE_X);
+
+              double rate = (double)cpu->stats.nodes
+                            * (double)SDL_GetPerformanceFrequency ()
+                            / (double)cpu->stats.search_ticks;
+              if (threads == 1)
+                {
+                  single_rate = rate;
+                }
+              printf ("%-10s %8d %14.0f %8.2f\n",
+                      mcts_names[engine - XO_CPU_ENGINE_MCTS], threads, rate,
+                      rate / single_rate);
+            }
+        }
+      cpu->config.threads = saved_threads;
+      xo_game_cpu_mcts_reset (&cpu->mcts, cpu->mcts.nodes, cpu->mcts.capacity);
+    }
+
+  cpu->config.engine = saved_engine;
+  xo_game_cpu_tt_clear (cpu);
+  if (xo_game_cpu_bench_variants (cpu) != 0)
+    {
+      return 1;
+    }
+  return xo_mnk_kernel_bench (cpu);
+}
+
+/// PROOF-NUMBER SEARCH
+
+/*
+ * Depth-first proof-number search (df-pn) proves that the attacker wins a
+ * position, or disproves it, by always expanding the most-proving position:
+ * the one whose result would settle the root with the least work. A
+ * position's proof number is the least number of positions that must be
+ * shown won to prove it, and its disproof number the least number that must be
+ * shown not won to disprove it. Only the positions on the current path are
+ * kept on the stack; every number computed goes to the table, and a subtree is
+ * searched until its numbers pass the thresholds its parent gave it.
+ *
+ * A draw is a disproof for both sides, so a game value takes up to two
+ * searches: one trying to prove a win for the side to move, then one for the
+ * other side.
+ */
+
+/**
+ * Adds proof or disproof numbers, saturating at XO_DFPN_INFINITY.
+ * @param a
+ * @param b
+ * @return
+ */
+static uint32_t
+xo_dfpn_add (uint32_t a, uint32_t b)
+{
+  return a + b >= XO_DFPN_INFINITY ? XO_DFPN_INFINITY : a + b;
+}
+
+/**
+ * Reads the proof and disproof numbers of a position from the table. A
+ * position not in the table keeps the numbers it has.
+ * @param dfpn
+ * @param child Position to look up, which receives the numbers
+ */
+static void
+xo_dfpn_lookup (struct xo_dfpn *dfpn, struct xo_dfpn_child *child)
+{
+  struct xo_dfpn_entry *bucket
+      = dfpn->table + (child->key & dfpn->bucket_mask) * XO_DFPN_BUCKET_SIZE;
+  for (int i = 0; i < XO_DFPN_BUCKET_SIZE; i++)
+    {
+      if (bucket[i].work != 0 && bucket[i].key == child->key)
+        {
+          child->proof = bucket[i].proof;
+          child->disproof = bucket[i].disproof;
+          return;
+        }
+    }
+}
+
+/**
+ * Writes the numbers of a position to the table. The position replaces its
+ * own entry, an empty one, or else the unsolved entry of its bucket with the
+ * least work. Proven and disproven entries are never replaced, as they are
+ * final, so the numbers are dropped when the bucket holds nothing else.
+ * @param dfpn
+ * @param key
+ * @param proof
+ * @param disproof
+ * @param work Nodes searched to compute the numbers
+ */
+static void
+xo_dfpn_store (struct xo_dfpn *dfpn, uint64_t key, uint32_t proof,
+               uint32_t disproof, uint64_t work)
+{
+  struct xo_dfpn_entry *bucket
+      = dfpn->table + (key & dfpn->bucket_mask) * XO_DFPN_BUCKET_SIZE;
+  struct xo_dfpn_entry *target = NULL;
+  for (int i = 0; i < XO_DFPN_BUCKET_SIZE; i++)
+    {
+      if (bucket[i].work == 0 || bucket[i].key == key)
+        {
+          target = &bucket[i];
+          break;
+        }
+      if (bucket[i].proof != 0 && bucket[i].disproof != 0
+          && (target == NULL || bucket[i].work < target->work))
+        {
+          target = &bucket[i];
+        }
+    }
+
+  if (target == NULL)
+    {
+      return;
+    }
+  if (target->work == 0)
+    {
+      dfpn->used++;
+    }
+  else if (target->key != key)
+    {
+      dfpn->replacements++;
+    }
+  target->key = key;
+  target->proof = proof;
+  target->disproof = disproof;
+  target->work = work;
+}
+
+/**
+ * Gives the threshold the best move of a node is searched to, from the number
+ * of the second best move: that number times 1 + 1/XO_DFPN_EPSILON, rounded
+ * up, and at least one more. With one more alone, moves of close numbers take
+ * turns after a node or two each, and a table too small for the whole tree
+ * throws away the subtree of one move while the other is searched.
+ * @param second
+ * @return
+ */
+static uint32_t
+xo_dfpn_threshold (uint32_t second)
+{
+  return xo_dfpn_add (
+      second, SDL_max (1u, (second + XO_DFPN_EPSILON - 1) / XO_DFPN_EPSILON));
+}
+
+/**
+ * Prints the progress of a solve: nodes, root numbers and table use.
+ * @param dfpn
+ */
+static void
+xo_dfpn_report (struct xo_dfpn *dfpn)
+{
+  size_t entries = (dfpn->bucket_mask + 1) * XO_DFPN_BUCKET_SIZE;
+  printf ("  %12" SDL_PRIu64 " nodes  proof %10u  disproof %10u  table "
+          "%5.1f%% full, %" SDL_PRIu64 " replaced  %8.1f s\n",
+          dfpn->nodes, dfpn->root_proof, dfpn->root_disproof,
+          100.0 * (double)dfpn->used / (double)entries, dfpn->replacements,
+          (double)(SDL_GetPerformanceCounter () - dfpn->start)
+              / (double)SDL_GetPerformanceFrequency ());
+  fflush (stdout);
+}
+
+/**
+ * Gives the hashes of the position after a move, one per symmetry.
+ * @param geometry
+ * @param keys Hashes of the position before the move
+ * @param side Side playing the move
+ * @param bit Cell of the move
+ * @param child_keys Receives the hashes
+ * @return The smallest hash, which is the same for every symmetric position
+ */
+static uint64_t
+xo_dfpn_child_keys (const struct xo_mnk_geometry *geometry,
+                    const uint64_t *keys, enum xo_bit_meaning_type side,
+                    uint16_t bit, uint64_t *child_keys)
+{
+  const uint64_t *zobrist = xo_mnk_zobrist[side == XO_BIT_MEANING_SIDE_O];
+  uint64_t canonical = UINT64_MAX;
+  for (uint8_t i = 0; i < geometry->symmetry_count; i++)
+    {
+      child_keys[i] = keys[i] ^ zobrist[xo_mnk_symmetry_bits[i][bit]];
+      canonical = SDL_min (canonical, child_keys[i]);
+    }
+  return canonical;
+}
+
+/**
+ * Searches a position until its proof number reaches proof_threshold or its
+ * disproof number reaches disproof_threshold, and stores its numbers. They
+ * are also given back, as the table may have had no room for them.
+ * @param dfpn The position is dfpn->board
+ * @param side Side to move
+ * @param keys Zobrist hashes of the position under each symmetry
+ * @param key Smallest of keys, under which the position is stored
+ * @param proof_threshold
+ * @param disproof_threshold
+ * @param ply Pieces played since the root, which picks the scratch moves
+ * @param position Receives the numbers of the position
+ */
+static void
+xo_dfpn_mid (struct xo_dfpn *dfpn, enum xo_bit_meaning_type side,
+             const uint64_t *keys, uint64_t key, uint32_t proof_threshold,
+             uint32_t disproof_threshold, uint16_t ply,
+             struct xo_dfpn_child *position)
+{
+  const struct xo_mnk_geometry *geometry = &dfpn->geometry;
+  struct xo_mnk_board *board = &dfpn->board;
+  struct xo_dfpn_child *children
+      = dfpn->children + (size_t)ply * geometry->cells;
+  struct xo_mnk_bits *own
+      = side == XO_BIT_MEANING_SIDE_X ? &board->x : &board->o;
+  SDL_bool b_attacker = side == dfpn->attacker;
+  uint64_t first_node = dfpn->nodes++;
+  uint16_t child_count = 0;
+
+  if (dfpn->nodes % XO_DFPN_REPORT_NODES == 0)
+    {
+      xo_dfpn_report (dfpn);
+    }
+
+  /* Moves to symmetric positions are kept once. Moves that end the game have
+   * final numbers: a win for the side to move, or a full board, which is no
+   * win for the attacker */
+  for (uint16_t bit = 0; bit < geometry->word_count * 64; bit++)
+    {
+      if (!xo_mnk_bits_test (&geometry->full, bit)
+          || xo_mnk_bits_test (&board->x, bit)
+          || xo_mnk_bits_test (&board->o, bit))
+        {
+          continue;
+        }
+
+      uint64_t child_keys[XO_BOARD_SYMMETRIES];
+      uint64_t child_key
+          = xo_dfpn_child_keys (geometry, keys, side, bit, child_keys);
+      uint16_t i = 0;
+      while (i < child_count && children[i].key != child_key)
+        {
+          i++;
+        }
+      if (i < child_count)
+        {
+          continue;
+        }
+
+      struct xo_dfpn_child *child = &children[child_count++];
+      child->bit = bit;
+      child->key = child_key;
+      child->proof = 1;
+      child->disproof = 1;
+      child->b_terminal = SDL_TRUE;
+
+      xo_mnk_bits_toggle (own, bit);
+      if (dfpn->kernel->has_line (geometry, own))
+        {
+          child->proof = b_attacker ? 0 : XO_DFPN_INFINITY;
+          child->disproof = b_attacker ? XO_DFPN_INFINITY : 0;
+        }
+      else if (board->count + 1 == geometry->cells)
+        {
+          child->proof = XO_DFPN_INFINITY;
+          child->disproof = 0;
+        }
+      else
+        {
+          child->b_terminal = SDL_FALSE;
+        }
+      xo_mnk_bits_toggle (own, bit);
+    }
+
+  for (;;)
+    {
+      /* The attacker needs one won move and the defender one move that is
+       * not lost: at a node where the attacker moves, the proof number is the
+       * smallest one of the moves and the disproof number is their sum, and
+       * the other way around where the defender moves */
+      uint32_t proof = b_attacker ? XO_DFPN_INFINITY : 0;
+      uint32_t disproof = b_attacker ? 0 : XO_DFPN_INFINITY;
+      uint32_t second = XO_DFPN_INFINITY;
+      uint16_t best = 0;
+      for (uint16_t i = 0; i < child_count; i++)
+        {
+          struct xo_dfpn_child *child = &children[i];
+          if (!child->b_terminal)
+            {
+              xo_dfpn_lookup (dfpn, child);
+            }
+
+          uint32_t minimized = b_attacker ? child->proof : child->disproof;
+          uint32_t *smallest = b_attacker ? &proof : &disproof;
+          if (minimized < *smallest)
+            {
+              second = *smallest;
+              *smallest = minimized;
+              best = i;
+            }
+          else if (minimized < second)
+            {
+              second = minimized;
+            }
+
+          if (b_attacker)
+            {
+              disproof = xo_dfpn_add (disproof, child->disproof);
+            }
+          else
+            {
+              proof = xo_dfpn_add (proof, child->proof);
+            }
+        }
+
+      if (ply == 0)
+        {
+          dfpn->root_proof = proof;
+          dfpn->root_disproof = disproof;
+        }
+      if (proof >= proof_threshold || disproof >= disproof_threshold)
+        {
+          xo_dfpn_store (dfpn, key, proof, disproof,
+                         dfpn->nodes - first_node);
+          position->proof = proof;
+          position->disproof = disproof;
+          return;
+        }
+
+      /* The most-proving move is searched until it falls behind the second
+       * best move by more than the margin of xo_dfpn_threshold, or until the
+       * node itself would pass its thresholds */
+      struct xo_dfpn_child *child = &children[best];
+      uint32_t child_proof_threshold;
+      uint32_t child_disproof_threshold;
+      if (b_attacker)
+        {
+          child_proof_threshold
+              = SDL_min (proof_threshold, xo_dfpn_threshold (second));
+          child_disproof_threshold
+              = disproof_threshold - disproof + child->disproof;
+        }
+      else
+        {
+          child_proof_threshold = proof_threshold - proof + child->proof;
+          child_disproof_threshold
+              = SDL_min (disproof_threshold, xo_dfpn_threshold (second));
+        }
+
+      uint64_t child_keys[XO_BOARD_SYMMETRIES];
+      xo_dfpn_child_keys (geometry, keys, side, child->bit, child_keys);
+      xo_mnk_bits_toggle (own, child->bit);
+      board->count++;
+      xo_dfpn_mid (dfpn,
+                   side == XO_BIT_MEANING_SIDE_X ? XO_BIT_MEANING_SIDE_O
+                                                 : XO_BIT_MEANING_SIDE_X,
+                   child_keys, child->key, child_proof_threshold,
+                   child_disproof_threshold, (uint16_t)(ply + 1), child);
+      board->count--;
+      xo_mnk_bits_toggle (own, child->bit);
+    }
+}
+
+/**
+ * Proves or disproves that a side wins the empty board, X moving first.
+ * @param dfpn
+ * @param attacker
+ * @return SDL_TRUE if attacker wins
+ */
+static SDL_bool
+xo_dfpn_prove (struct xo_dfpn *dfpn, enum xo_bit_meaning_type attacker)
+{
+  memset (dfpn->table, 0,
+          (dfpn->bucket_mask + 1) * XO_DFPN_BUCKET_SIZE
+              * sizeof (struct xo_dfpn_entry));
+  dfpn->used = 0;
+  dfpn->board = (struct xo_mnk_board){ 0 };
+  dfpn->attacker = attacker;
+  const uint64_t keys[XO_BOARD_SYMMETRIES] = { 0 };
+  struct xo_dfpn_child root = { 0 };
+  xo_dfpn_mid (dfpn, XO_BIT_MEANING_SIDE_X, keys, 0, XO_DFPN_INFINITY,
+               XO_DFPN_INFINITY, 0, &root);
+  xo_dfpn_report (dfpn);
+  return dfpn->root_proof == 0 ? SDL_TRUE : SDL_FALSE;
+}
+
+/**
+ * Solves an m,n,k game headless and prints its value, with the progress and
+ * the memory of the search. The table takes all that is left of the generic
+ * stack, so --memory sets its size.
+ * @param width
+ * @param height
+ * @param k
+ * @return 0 for success
+ */
+static int32_t
+xo_dfpn_solve (uint8_t width, uint8_t height, uint8_t k)
+{
+  struct xo_dfpn dfpn = { 0 };
+  if (xo_mnk_geometry_init (&dfpn.geometry, width, height, k) != 0)
+    {
+      return 1;
+    }
+  dfpn.kernel = xo_mnk_kernel_find (&dfpn.geometry);
+
+  size_t children_size = (size_t)dfpn.geometry.cells * dfpn.geometry.cells
+                         * sizeof (struct xo_dfpn_child);
+  dfpn.children
+      = (struct xo_dfpn_child *)xo_stack_alloc (generic, children_size);
+  if (dfpn.children == NULL)
+    {
+      return 1;
+    }
+
+  /* The largest power of two of buckets that fits in the generic stack */
+  size_t bucket_size = XO_DFPN_BUCKET_SIZE * sizeof (struct xo_dfpn_entry);
+  size_t free_size = generic->size - generic->offset - XO_STACK_ALIGNMENT;
+  size_t buckets = 1;
+  while (buckets * 2 * bucket_size <= free_size)
+    {
+      buckets *= 2;
+    }
+  dfpn.table = (struct xo_dfpn_entry *)xo_stack_alloc (generic,
+                                                       buckets * bucket_size);
+  if (dfpn.table == NULL)
+    {
+      return 1;
+    }
+  dfpn.bucket_mask = buckets - 1;
+
+  printf ("Solving %ux%u k=%u with df-pn: %zu table entries, %zu KB\n", width,
+          height, k, buckets * XO_DFPN_BUCKET_SIZE,
+          (buckets * bucket_size + children_size) / 1024);
+
+  enum xo_win_state_type value = XO_WIN_STATE_TIE;
+  dfpn.start = SDL_GetPerformanceCounter ();
+  printf ("Does X win?\n");
+  if (xo_dfpn_prove (&dfpn, XO_BIT_MEANING_SIDE_X))
+    {
+      value = XO_WIN_STATE_X_WIN;
+    }
+  else
+    {
+      printf ("Does O win?\n");
+      if (xo_dfpn_prove (&dfpn, XO_BIT_MEANING_SIDE_O))
+        {
+          value = XO_WIN_STATE_O_WIN;
+        }
+    }
+
+  printf ("%ux%u k=%u: %s with perfect play, %" SDL_PRIu64
+          " nodes in %.1f s\n",
+          width, height, k, xo_util_win_state_type_to_string (value),
+          dfpn.nodes,
+          (double)(SDL_GetPerformanceCounter () - dfpn.start)
+              / (double)SDL_GetPerformanceFrequency ());
+  return 0;
+}
+
+/// THREAT-SPACE SEARCH
+
+/*
+ * On a large board a full-width search cannot see far, but most long wins in
+ * k-in-a-row games are forced: the attacker only plays threats, so the
+ * defender only has a few replies that do not lose at once. Threat-space
+ * search only follows such lines. The attacker plays fours, which the
+ * defender has to block, and threes, which threaten a double four; the
+ * defender tries every reply that stops the threat, including counter-fours.
+ * The threats are found for the whole board at once with
+ * xo_mnk_completions, which extends the line counting of
+ * xo_board_validate_win_conditions_for to any board and line length. A win
+ * found this way is a real win, but a position where the attacker needs a
+ * quiet move to win is not found.
+ */
+
+/**
+ * Gives the pieces of a side of the threat-space search board.
+ * @param tss
+ * @param side
+ * @return
+ */
+static struct xo_mnk_bits *
+xo_tss_pieces (struct xo_tss *tss, enum xo_bit_meaning_type side)
+{
+  return side == XO_BIT_MEANING_SIDE_X ? &tss->board.x : &tss->board.o;
+}
+
+/**
+ * Gives the empty cells of the threat-space search board.
+ * @param tss
+ * @param empty Receives the cells
+ */
+static void
+xo_tss_empty (const struct xo_tss *tss, struct xo_mnk_bits *empty)
+{
+  for (uint8_t word = 0; word < tss->geometry.word_count; word++)
+    {
+      empty->words[word] = tss->geometry.full.words[word]
+                           & ~(tss->board.x.words[word]
+                               | tss->board.o.words[word]);
+    }
+}
+
+/**
+ * Counts a node of the threat-space search, and tells whether the search is
+ * over its limits. The deadline is only read every 256 nodes.
+ * @param tss
+ * @return
+ */
+static SDL_bool
+xo_tss_out_of_budget (struct xo_tss *tss)
+{
+  tss->nodes++;
+  if (!tss->b_aborted
+      && ((tss->node_limit != 0 && tss->nodes >= tss->node_limit)
+          || (tss->deadline != 0 && tss->nodes % 256 == 0
+              && SDL_GetPerformanceCounter () >= tss->deadline)))
+    {
+      tss->b_aborted = SDL_TRUE;
+    }
+  return tss->b_aborted;
+}
+
+/**
+ * Plays or takes back a move on the threat-space search board.
+ * @param tss
+ * @param side
+ * @param bit Cell of the move
+ */
+static void
+xo_tss_toggle (struct xo_tss *tss, enum xo_bit_meaning_type side,
+               uint16_t bit)
+{
+  xo_mnk_bits_toggle (xo_tss_pieces (tss, side), bit);
+  tss->key ^= xo_mnk_zobrist[side == XO_BIT_MEANING_SIDE_O][bit];
+}
+
+static SDL_bool xo_tss_defend (struct xo_tss *tss, uint8_t depth);
+
+/**
+ * Looks for a threat sequence that wins for the attacker, who is to move.
+ * Positions without one are kept in the table, with the depth searched.
+ * @param tss
+ * @param depth Threats the attacker may still play before the winning move
+ * @param move Receives the first move of the win
+ * @return SDL_TRUE if one was found
+ */
+static SDL_bool
+xo_tss_attack (struct xo_tss *tss, uint8_t depth, uint16_t *move)
+{
+  const struct xo_mnk_geometry *geometry = &tss->geometry;
+  uint8_t word_count = geometry->word_count;
+  const struct xo_mnk_bits *own = xo_tss_pieces (tss, tss->attacker);
+  const struct xo_mnk_bits *other = xo_tss_pieces (tss, tss->defender);
+  struct xo_mnk_bits empty;
+  struct xo_mnk_bits wins;
+
+  if (xo_tss_out_of_budget (tss))
+    {
+      return SDL_FALSE;
+    }
+
+  xo_tss_empty (tss, &empty);
+  xo_mnk_completions (geometry, own, &empty, 1, &wins);
+  uint16_t bit = xo_mnk_bits_next (&wins, 0, word_count);
+  if (bit != XO_MNK_BITS)
+    {
+      *move = bit;
+      return SDL_TRUE;
+    }
+  if (depth == 0)
     {
-      return XO_WIN_STATE_X_WIN;
+      tss->b_cut = SDL_TRUE;
+      return SDL_FALSE;
     }
-  if (xo_board_validate_win_conditions_for (board_data, XO_BIT_MEANING_SIDE_O)
-      == SDL_TRUE)
+
+  struct xo_tss_entry *entry
+      = &tss->table[tss->key & (XO_TSS_TABLE_SIZE - 1)];
+  if (entry->key == tss->key && entry->depth >= depth)
     {
-      return XO_WIN_STATE_O_WIN;
+      tss->b_cut = tss->b_cut || entry->depth <= XO_TSS_MAX_DEPTH;
+      return SDL_FALSE;
     }
-  if (xo_board_check_if_full (board_data) == SDL_TRUE)
+
+  /* A four of the defender has to be blocked, whether or not the block is a
+   * threat; two cannot be */
+  struct xo_mnk_bits candidates[2] = { 0 };
+  uint8_t candidate_sets = 1;
+  xo_mnk_completions (geometry, other, &empty, 1, &candidates[0]);
+  uint16_t defender_wins = xo_mnk_bits_count (&candidates[0], word_count);
+  if (defender_wins >= 2)
     {
-      return XO_WIN_STATE_TIE;
+      candidates[0] = (struct xo_mnk_bits){ 0 };
+    }
+  else if (defender_wins == 0)
+    {
+      /* Fours first, as they leave the defender a single reply */
+      xo_mnk_completions (geometry, own, &empty, 2, &candidates[0]);
+      xo_mnk_completions (geometry, own, &empty, 3, &candidates[1]);
+      for (uint8_t word = 0; word < word_count; word++)
+        {
+          candidates[1].words[word] &= ~candidates[0].words[word];
+        }
+      candidate_sets = 2;
     }
 
-  return XO_WIN_STATE_NONE;
+  /* b_cut is gathered for this position alone, to know what to store */
+  SDL_bool b_parent_cut = tss->b_cut;
+  SDL_bool b_win = SDL_FALSE;
+  tss->b_cut = SDL_FALSE;
+  for (uint8_t set = 0; set < candidate_sets && !b_win; set++)
+    {
+      for (bit = xo_mnk_bits_next (&candidates[set], 0, word_count);
+           bit != XO_MNK_BITS && !b_win && !tss->b_aborted;
+           bit = xo_mnk_bits_next (&candidates[set], (uint16_t)(bit + 1),
+                                   word_count))
+        {
+          xo_tss_toggle (tss, tss->attacker, bit);
+          b_win = xo_tss_defend (tss, (uint8_t)(depth - 1));
+          xo_tss_toggle (tss, tss->attacker, bit);
+          if (b_win)
+            {
+              *move = bit;
+            }
+        }
+    }
+
+  if (!b_win && !tss->b_aborted)
+    {
+      entry->key = tss->key;
+      entry->depth = tss->b_cut ? depth : XO_TSS_MAX_DEPTH + 1;
+    }
+  tss->b_cut = tss->b_cut || b_parent_cut;
+  return b_win;
 }
 
 /**
- * Play a move at the specified square coordinates for the specified side. A
- * check is made to ensure the square is empty, since the human-controlled
- * player can click a non-valid square.
- * @param app
- * @param side
- * @param col
- * @param row
- * @return
+ * Tells whether every reply of the defender, who is to move, to the last
+ * threat of the attacker still loses to a threat sequence. The replies that
+ * neither block the threat nor make a four lose at once, so only the others
+ * are searched.
+ * @param tss
+ * @param depth Threats the attacker may still play before the winning move
+ * @return SDL_TRUE if the attacker wins
  */
 static SDL_bool
-xo_game_play (struct xo_app *app, enum xo_bit_meaning_type side, int col,
-              int row)
+xo_tss_defend (struct xo_tss *tss, uint8_t depth)
 {
-  if (xo_board_bit_check_at (app->game->board->data, XO_BIT_MEANING_EMPTY, col,
-                             row))
+  const struct xo_mnk_geometry *geometry = &tss->geometry;
+  uint8_t word_count = geometry->word_count;
+  struct xo_mnk_bits *own = xo_tss_pieces (tss, tss->attacker);
+  const struct xo_mnk_bits *other = xo_tss_pieces (tss, tss->defender);
+  struct xo_mnk_bits empty;
+  struct xo_mnk_bits wins;
+  struct xo_mnk_bits replies;
+
+  if (xo_tss_out_of_budget (tss))
+    {
+      return SDL_FALSE;
+    }
+
+  xo_tss_empty (tss, &empty);
+  xo_mnk_completions (geometry, other, &empty, 1, &wins);
+  if (xo_mnk_bits_next (&wins, 0, word_count) != XO_MNK_BITS)
+    {
+      return SDL_FALSE;
+    }
+
+  xo_mnk_completions (geometry, own, &empty, 1, &wins);
+  uint16_t win_count = xo_mnk_bits_count (&wins, word_count);
+  if (win_count >= 2)
     {
-      xo_log_debug (1, SDL_FALSE, "Playing!");
-      xo_board_bit_clear_at (app->game->board->data, XO_BIT_MEANING_EMPTY, col,
-                             row);
-      xo_board_bit_set_at (app->game->board->data, side, col, row);
       return SDL_TRUE;
     }
+  if (win_count == 1)
+    {
+      replies = wins;
+    }
   else
     {
-      xo_log_debug (1, SDL_FALSE, "Tile is occupied. Click ignored...");
-      return SDL_FALSE;
+      /* The attacker made a three: each cell where it would next make two
+       * fours has to be taken, or one of the two fours blocked, unless the
+       * defender answers with a four of its own */
+      struct xo_mnk_bits threats;
+      struct xo_mnk_bits fours;
+      xo_mnk_double_fours (geometry, own, &empty, &threats);
+      if (xo_mnk_bits_next (&threats, 0, word_count) == XO_MNK_BITS)
+        {
+          return SDL_FALSE;
+        }
+
+      replies = empty;
+      for (uint16_t bit = xo_mnk_bits_next (&threats, 0, word_count);
+           bit != XO_MNK_BITS;
+           bit = xo_mnk_bits_next (&threats, (uint16_t)(bit + 1), word_count))
+        {
+          struct xo_mnk_bits stops = { 0 };
+          xo_mnk_bits_toggle (own, bit);
+          xo_mnk_bits_toggle (&empty, bit);
+          xo_mnk_completions (geometry, own, &empty, 1, &wins);
+          xo_mnk_bits_toggle (&empty, bit);
+          xo_mnk_bits_toggle (own, bit);
+
+          if (xo_mnk_bits_count (&wins, word_count) == 2)
+            {
+              stops = wins;
+            }
+          xo_mnk_bits_toggle (&stops, bit);
+          for (uint8_t word = 0; word < word_count; word++)
+            {
+              replies.words[word] &= stops.words[word];
+            }
+        }
+
+      xo_mnk_completions (geometry, other, &empty, 2, &fours);
+      for (uint8_t word = 0; word < word_count; word++)
+        {
+          replies.words[word] |= fours.words[word];
+        }
+    }
+
+  for (uint16_t bit = xo_mnk_bits_next (&replies, 0, word_count);
+       bit != XO_MNK_BITS;
+       bit = xo_mnk_bits_next (&replies, (uint16_t)(bit + 1), word_count))
+    {
+      uint16_t move = 0;
+      xo_tss_toggle (tss, tss->defender, bit);
+      SDL_bool b_win = xo_tss_attack (tss, depth, &move);
+      xo_tss_toggle (tss, tss->defender, bit);
+      if (!b_win)
+        {
+          return SDL_FALSE;
+        }
     }
+  return SDL_TRUE;
 }
 
 /**
- * This function conducts a minimax evaluation of the provided board.
- * @param last_board
- * @param side
- * @return
+ * Looks for a threat win of the side to move, one threat deeper at a time,
+ * until one is found, the limits are reached or deeper searches cannot find
+ * more.
+ * @param tss The position is tss->board, and tss->attacker is to move
+ * @param move Receives the first move of the win
+ * @param depth Receives the threats played before the winning move
+ * @return SDL_TRUE if a win was found
  */
-static struct xo_cpu_response
-xo_game_cpu_minimax_eval (struct xo_board_data *last_board,
-                          enum xo_bit_meaning_type side)
+static SDL_bool
+xo_tss_search (struct xo_tss *tss, uint16_t *move, uint8_t *depth)
 {
-  struct xo_cpu_response new_response;
-
-  /* Checks if the game is over (someone won or the board is full) */
-  enum xo_win_state_type board_win_state
-      = xo_board_test_if_final_state (last_board);
-
-  /* A None state would mean the game is still on-going*/
-  if (board_win_state != XO_WIN_STATE_NONE)
+  for (*depth = 0; *depth <= XO_TSS_MAX_DEPTH; (*depth)++)
     {
-      xo_log_debug (
-          2, SDL_FALSE, "CPU found a terminal move of type: %s with score %d",
-          xo_util_win_state_type_to_string (board_win_state), board_win_state);
-      new_response.score = (int32_t)board_win_state;
-      new_response.has_move = SDL_FALSE;
-      return new_response;
+      tss->b_cut = SDL_FALSE;
+      if (xo_tss_attack (tss, *depth, move))
+        {
+          return SDL_TRUE;
+        }
+      if (tss->b_aborted || !tss->b_cut)
+        {
+          break;
+        }
     }
+  return SDL_FALSE;
+}
 
-  /* Set the best score depending on which side is simulated. */
-  int32_t best_score = side == XO_BIT_MEANING_SIDE_O ? INT32_MIN : INT32_MAX;
-  SDL_Point best_move;
-  SDL_bool move_found = SDL_FALSE;
-
-  /* Iterates over the board */
-  for (uint8_t col = 0; col < 3; col++)
+/**
+ * Sets up a threat-space search of a position, without limits.
+ * @param tss Receives the search
+ * @param geometry
+ * @param board
+ * @param attacker Side the win is looked for, as if it were to move
+ * @param table XO_TSS_TABLE_SIZE cleared entries
+ */
+static void
+xo_tss_init (struct xo_tss *tss, const struct xo_mnk_geometry *geometry,
+             const struct xo_mnk_board *board,
+             enum xo_bit_meaning_type attacker, struct xo_tss_entry *table)
+{
+  *tss = (struct xo_tss){ 0 };
+  tss->geometry = *geometry;
+  tss->board = *board;
+  tss->table = table;
+  tss->attacker = attacker;
+  tss->defender = attacker == XO_BIT_MEANING_SIDE_X ? XO_BIT_MEANING_SIDE_O
+                                                    : XO_BIT_MEANING_SIDE_X;
+  for (uint16_t bit = 0; bit < XO_MNK_BITS; bit++)
     {
-      for (uint8_t row = 0; row < 3; row++)
+      if (xo_mnk_bits_test (&board->x, bit))
         {
-          /* When we hit an empty square. . . */
-          if (xo_board_bit_check_at (last_board, XO_BIT_MEANING_EMPTY, col,
-                                     row)
-              == SDL_TRUE)
-            {
-              /* Create a copy of the board data, set the empty square as
-               * marked by the simulated_side. */
-              struct xo_board_data *new_board
-                  = (struct xo_board_data *)calloc (
-                      1, sizeof (struct xo_board_data));
-
-              memcpy (new_board->squares, last_board->squares,
-                      sizeof (uint8_t) * XO_BOARD_SIZE * XO_BOARD_SIZE);
-
-              xo_board_bit_clear_at (new_board, XO_BIT_MEANING_EMPTY, col,
-                                     row);
-              xo_board_bit_set_at (new_board, (uint8_t)side, col, row);
+          tss->key ^= xo_mnk_zobrist[0][bit];
+        }
+      if (xo_mnk_bits_test (&board->o, bit))
+        {
+          tss->key ^= xo_mnk_zobrist[1][bit];
+        }
+    }
+}
 
-              /* Create a nested minimax evaluation using that new board as a
-               * root. */
-              struct xo_cpu_response response = xo_game_cpu_minimax_eval (
-                  new_board, side == XO_BIT_MEANING_SIDE_O
-                                 ? XO_BIT_MEANING_SIDE_X
-                                 : XO_BIT_MEANING_SIDE_O);
+/**
+ * Looks for a threat win in a position of a game, within a share of the
+ * budget of the move, see xo_tss_cpu_move.
+ * @param cpu
+ * @param tss Receives the search
+ * @param geometry
+ * @param board
+ * @param attacker Side the win is looked for, as if it were to move
+ * @param table XO_TSS_TABLE_SIZE entries, cleared here
+ * @param move Receives the first move of the win
+ * @return SDL_TRUE if a win was found
+ */
+static SDL_bool
+xo_tss_cpu_search (struct xo_cpu *cpu, struct xo_tss *tss,
+                   const struct xo_mnk_geometry *geometry,
+                   const struct xo_mnk_board *board,
+                   enum xo_bit_meaning_type attacker,
+                   struct xo_tss_entry *table, uint16_t *move)
+{
+  uint32_t time_ms = cpu->config.time_limit_ms != 0
+                         ? cpu->config.time_limit_ms
+                         : XO_MNK_CPU_TIME_MS;
+  memset (table, 0, XO_TSS_TABLE_SIZE * sizeof (struct xo_tss_entry));
+  xo_tss_init (tss, geometry, board, attacker, table);
+  tss->deadline = SDL_GetPerformanceCounter ()
+                  + SDL_GetPerformanceFrequency () * time_ms / 1000
+                        / XO_MNK_TSS_SHARE;
+  if (cpu->config.node_limit != 0)
+    {
+      tss->node_limit = cpu->config.node_limit / XO_MNK_TSS_SHARE + 1;
+    }
 
-              if (side == XO_BIT_MEANING_SIDE_O)
-                {
-                  if (response.score > best_score)
-                    {
-                      best_score = response.score;
-                      best_move.x = col;
-                      best_move.y = row;
-                      move_found = SDL_TRUE;
-                    }
-                }
-              else if (side == XO_BIT_MEANING_SIDE_X)
-                {
-                  if (response.score < best_score)
-                    {
-                      best_score = response.score;
-                      best_move.x = col;
-                      best_move.y = row;
-                      move_found = SDL_TRUE;
-                    }
-                }
+  uint8_t depth = 0;
+  SDL_bool b_win = xo_tss_search (tss, move, &depth);
+  cpu->stats.nodes += tss->nodes;
+  xo_log_debug (2, SDL_FALSE,
+                "CPU threat search for %s: %s, %u threats deep, "
+                "%" SDL_PRIu64 " nodes",
+                attacker == XO_BIT_MEANING_SIDE_X ? "X" : "O",
+                b_win ? "win" : "none", depth, tss->nodes);
+  return b_win;
+}
 
-              free (new_board);
-            }
-        }
+/**
+ * Looks for the CPU move of an m,n,k game by threat-space search, which sees
+ * the long forced wins the full-width search cannot. The move is the first
+ * of a threat win of the side to move or, when the opponent has one, the
+ * first cell of that win, if taking it leaves the opponent without one. Each
+ * search stops at 1/XO_MNK_TSS_SHARE of the time and node budget of the move.
+ * @param cpu
+ * @param geometry
+ * @param board Position, which must not be over
+ * @param side Side to move
+ * @param score Receives the score of the move for the side to move
+ * @param move Receives the move, as a cell bit
+ * @return SDL_TRUE if a move was found
+ */
+static SDL_bool
+xo_tss_cpu_move (struct xo_cpu *cpu, const struct xo_mnk_geometry *geometry,
+                 const struct xo_mnk_board *board,
+                 enum xo_bit_meaning_type side, int32_t *score,
+                 uint16_t *move)
+{
+  size_t mark = xo_stack_mark (generic);
+  struct xo_tss_entry *table = (struct xo_tss_entry *)xo_stack_alloc (
+      generic, XO_TSS_TABLE_SIZE * sizeof (struct xo_tss_entry));
+  if (table == NULL)
+    {
+      return SDL_FALSE;
     }
 
-  new_response.score = best_score;
-  new_response.has_move = move_found;
-  if (move_found)
+  enum xo_bit_meaning_type other_side = side == XO_BIT_MEANING_SIDE_X
+                                            ? XO_BIT_MEANING_SIDE_O
+                                            : XO_BIT_MEANING_SIDE_X;
+  struct xo_tss tss;
+  uint16_t block = 0;
+  SDL_bool b_found = SDL_FALSE;
+  if (xo_tss_cpu_search (cpu, &tss, geometry, board, side, table, move))
     {
-      new_response.move = best_move;
+      *score = XO_MNK_SCORE_WIN;
+      b_found = SDL_TRUE;
     }
-  return new_response;
+  else if (xo_tss_cpu_search (cpu, &tss, geometry, board, other_side, table,
+                              &block))
+    {
+      /* The block is only played when it is known to stop every threat
+       * win; otherwise the full-width search looks for a defence */
+      struct xo_mnk_board blocked = *board;
+      uint16_t unused = 0;
+      xo_mnk_bits_toggle (side == XO_BIT_MEANING_SIDE_X ? &blocked.x
+                                                        : &blocked.o,
+                          block);
+      blocked.count++;
+      if (!xo_tss_cpu_search (cpu, &tss, geometry, &blocked, other_side,
+                              table, &unused)
+          && !tss.b_aborted)
+        {
+          *score = 0;
+          *move = block;
+          b_found = SDL_TRUE;
+        }
+    }
+  xo_stack_rewind (generic, mark);
+  return b_found;
 }
 
 /**
- * Bad version of the cpu AI which just picks the first available square
- * left-right, top-down. I put this while testing the minimax when it is
- * crashing. Leaving it here in case I rework AI and need it again.
- * @param app
+ * Plays a list of moves on an m,n,k board, from X on and alternating. The
+ * moves are separated by commas, each as a column letter and a row number
+ * from 1, such as "h8,h9,i8".
+ * @param geometry
+ * @param position
+ * @param board Receives the board
+ * @return 0 for success, 1 if a move is invalid or ends the game
  */
-// NOW DISABLED
+static int32_t
+xo_tss_play_position (const struct xo_mnk_geometry *geometry,
+                      const char *position, struct xo_mnk_board *board)
+{
+  *board = (struct xo_mnk_board){ 0 };
+  const char *cursor = position;
+  while (cursor != NULL && *cursor != '\0')
+    {
+      char column = 0;
+      unsigned int row = 0;
+      if (sscanf (cursor, "%c%u", &column, &row) != 2 || column < 'a'
+          || column >= 'a' + geometry->width || row < 1
+          || row > geometry->height)
+        {
+          xo_log_error (SDL_FALSE, "Invalid move in position: %s\n", cursor);
+          return 1;
+        }
 
-// static SDL_Point
-// xo_game_cpu_find_next_play_BAD (struct xo_app *app)
-//{
-//  for (int row = 0; row < 3; row++)
-//    {
-//      for (int col = 0; col < 3; col++)
-//        {
-//          if (xo_board_bit_check_at (app->game->board->data,
-//                                     XO_BIT_MEANING_EMPTY, col, row)
-//              == SDL_TRUE)
-//            {
-//              return (SDL_Point){ col, row };
-//            }
-//        }
-//    }
-//
-//  return (SDL_Point){ -1, -1 };
-//}
+      uint16_t bit = (uint16_t)((row - 1) * geometry->stride
+                                + (unsigned)(column - 'a'));
+      struct xo_mnk_bits *pieces = board->count % 2 == 0 ? &board->x
+                                                         : &board->o;
+      if (xo_mnk_bits_test (&board->x, bit)
+          || xo_mnk_bits_test (&board->o, bit))
+        {
+          xo_log_error (SDL_FALSE, "Square taken twice in position: %s\n",
+                        cursor);
+          return 1;
+        }
+      xo_mnk_bits_toggle (pieces, bit);
+      board->count++;
+      if (xo_mnk_has_line (geometry, pieces))
+        {
+          xo_log_error (SDL_FALSE, "The game is over in position: %s\n",
+                        cursor);
+          return 1;
+        }
+
+      cursor = strchr (cursor, ',');
+      if (cursor != NULL)
+        {
+          cursor++;
+        }
+    }
+  return 0;
+}
 
 /**
- * Plays the AI move, thus returning a result from a minimax evaluation.
- * @param current_board the last board
- * @return
+ * Searches a position of an m,n,k game headless for a threat win of the side
+ * to move, and prints it.
+ * @param width
+ * @param height
+ * @param k
+ * @param position Moves played, see xo_tss_play_position, or NULL
+ * @param time_limit_ms 0 for no limit
+ * @param node_limit 0 for no limit
+ * @return 0 for success
  */
-static SDL_Point
-xo_game_cpu_find_next_play (struct xo_app *app)
+static int32_t
+xo_tss_report (uint8_t width, uint8_t height, uint8_t k, const char *position,
+               uint32_t time_limit_ms, uint64_t node_limit)
 {
-  xo_log_debug (1, SDL_FALSE, "CPU begins looking for move. . .");
-
-  struct xo_cpu_response response = xo_game_cpu_minimax_eval (
-      app->game->board->data, XO_BIT_MEANING_SIDE_O);
+  struct xo_mnk_geometry geometry;
+  struct xo_mnk_board board;
+  if (xo_mnk_geometry_init (&geometry, width, height, k) != 0
+      || xo_tss_play_position (&geometry, position, &board) != 0)
+    {
+      return 1;
+    }
+  struct xo_tss_entry *table = (struct xo_tss_entry *)xo_stack_alloc (
+      generic, XO_TSS_TABLE_SIZE * sizeof (struct xo_tss_entry));
+  if (table == NULL)
+    {
+      return 1;
+    }
 
-  xo_log_debug (1, SDL_FALSE, "CPU brain returned move %d, %d with score %d",
-                response.move.x, response.move.y, response.score);
+  struct xo_tss tss;
+  xo_tss_init (&tss, &geometry, &board,
+               board.count % 2 == 0 ? XO_BIT_MEANING_SIDE_X
+                                    : XO_BIT_MEANING_SIDE_O,
+               table);
+  tss.node_limit = node_limit;
+  Uint64 start = SDL_GetPerformanceCounter ();
+  if (time_limit_ms != 0)
+    {
+      tss.deadline
+          = start + SDL_GetPerformanceFrequency () * time_limit_ms / 1000;
+    }
 
-  return response.move;
+  uint16_t move = 0;
+  uint8_t depth = 0;
+  SDL_bool b_win = xo_tss_search (&tss, &move, &depth);
+  double ms = (double)(SDL_GetPerformanceCounter () - start) * 1000.0
+              / (double)SDL_GetPerformanceFrequency ();
+  const char *attacker = tss.attacker == XO_BIT_MEANING_SIDE_X ? "X" : "O";
+  if (b_win)
+    {
+      printf ("%s wins by threats: play %c%u, %u threats before the win, "
+              "%" SDL_PRIu64 " nodes in %.1f ms\n",
+              attacker, 'a' + move % tss.geometry.stride,
+              move / tss.geometry.stride + 1, depth, tss.nodes, ms);
+    }
+  else
+    {
+      printf ("No threat win for %s%s, %u threats deep, %" SDL_PRIu64
+              " nodes in %.1f ms\n",
+              attacker, tss.b_aborted ? " within the limits" : "", depth,
+              tss.nodes, ms);
+    }
+  return 0;
 }
+#endif
 
 int32_t
 xo_exit (int32_t code)
 {
+  xo_stack_destroy (minimax_stack);
+  xo_stack_destroy (generic);
   SDL_Quit ();
   exit (code);
   return code;
 }
 
+#ifdef XO_GEN_TABLE
+/**
+ * Solves every legal 3x3 position with the CPU search and writes the results
+ * as a C table, indexed by xo_board_index. X always moves first, so the side
+ * to move follows from the piece counts. Illegal positions, and positions
+ * where the game is over, have no move.
+ * @param cpu
+ * @param path Output header
+ * @return 0 for success
+ */
+static int32_t
+xo_gen_table_write (struct xo_cpu *cpu, const char *path)
+{
+  FILE *file = fopen (path, "w");
+  if (file == NULL)
+    {
+      xo_log_error (SDL_TRUE, "Error: could not open %s\n", path);
+      return 1;
+    }
+
+  fprintf (file, "/* Generated by xo_gen_table from game.c. Do not edit. */\n"
+                 "static const struct xo_table_entry xo_table[XO_TABLE_SIZE] "
+                 "= {\n");
+
+  for (uint16_t index = 0; index < XO_TABLE_SIZE; index++)
+    {
+      struct xo_board_data board_data = { 0 };
+      int x_count = 0;
+      int o_count = 0;
+      uint16_t digits = index;
+      for (uint8_t square = 0; square < XO_BOARD_SQUARES; square++)
+        {
+          if (digits % 3 == 1)
+            {
+              board_data.x |= (uint16_t)(1u << square);
+              x_count++;
+            }
+          else if (digits % 3 == 2)
+            {
+              board_data.o |= (uint16_t)(1u << square);
+              o_count++;
+            }
+          digits /= 3;
+        }
+      xo_board_count_lines (&board_data);
+
+      struct xo_cpu_response response = { 0 };
+      response.score = XO_WIN_STATE_TIE;
+      enum xo_win_state_type state = xo_board_test_if_final_state (&board_data);
+      if (x_count - o_count != 0 && x_count - o_count != 1)
+        {
+          /* Illegal, left empty */
+        }
+      else if (state != XO_WIN_STATE_NONE)
+        {
+          response.score = xo_game_cpu_score_final (&board_data, state);
+        }
+      else
+        {
+          response = xo_game_cpu_search (cpu, &board_data,
+                                         x_count > o_count
+                                             ? XO_BIT_MEANING_SIDE_O
+                                             : XO_BIT_MEANING_SIDE_X);
+        }
+
+      fprintf (file, "  { %d, %d },\n", response.score,
+               response.has_move ? response.move.y * XO_BOARD_SIZE
+                                       + response.move.x
+                                 : XO_CPU_NO_MOVE);
+    }
+
+  fprintf (file, "};\n");
+  fclose (file);
+  return 0;
+}
+
+/* Build-time table generator : */
+
+int
+main (int argc, char *argv[])
+{
+  struct xo_cpu cpu = { 0 };
+
+  if (argc != 2 && argc != 3)
+    {
+      xo_log_error (SDL_TRUE, "Usage: xo_gen_table <output header> [<output "
+                              "tablebase>]\n");
+      return 1;
+    }
+
+  xo_init_default_cpu_config (&cpu.config);
+  if (xo_init_memory (&cpu.config) != 0
+      || xo_game_cpu_init (&cpu, NULL) != 0)
+    {
+      return 1;
+    }
+
+  int32_t result = xo_gen_table_write (&cpu, argv[1]);
+
+  /* The 3x3 tablebase, for --cpu-table=tablebase */
+  if (result == 0 && argc == 3)
+    {
+      struct xo_mnk_geometry geometry;
+      struct xo_tablebase *tablebase = (struct xo_tablebase *)xo_stack_alloc (
+          generic, sizeof (struct xo_tablebase));
+      result = tablebase == NULL
+               || xo_mnk_geometry_init (&geometry, XO_BOARD_SIZE,
+                                        XO_BOARD_SIZE, XO_BOARD_SIZE)
+                      != 0
+               || xo_tablebase_build (tablebase, &geometry, 0,
+                                      cpu.config.threads, SDL_FALSE)
+                      != 0
+               || xo_tablebase_write (tablebase, argv[2]) != 0;
+    }
+  xo_stack_destroy (minimax_stack);
+  xo_stack_destroy (generic);
+  return result;
+}
+#else
 /* This is the actual program logical sequence : */
 
 int
@@ -1541,6 +10349,47 @@ main (int argc, char *argv[])
     }
   app->game->game_state = XO_GAME_STATE_NULL;
 
+  if (xo_init_parse_args (app, argc, argv) != 0
+      || xo_mnk_geometry_init (&app->game->geometry, app->board_width,
+                               app->board_height, app->board_k)
+             != 0
+      || xo_init_memory (&app->game->cpu.config) != 0
+      || xo_game_cpu_init (&app->game->cpu,
+                           app->game->variant == XO_VARIANT_MNK
+                               ? &app->game->geometry
+                               : NULL)
+             != 0)
+    {
+      return xo_exit (1);
+    }
+
+  if (app->b_bench)
+    {
+      return xo_exit (xo_game_cpu_bench (&app->game->cpu));
+    }
+
+  if (app->solve_width != 0)
+    {
+      return xo_exit (
+          xo_dfpn_solve (app->solve_width, app->solve_height, app->solve_k));
+    }
+
+  if (app->tablebase_width != 0)
+    {
+      return xo_exit (xo_tablebase_report (
+          app->tablebase_width, app->tablebase_height, app->tablebase_k,
+          app->tablebase_pieces, app->game->cpu.config.threads,
+          app->game->cpu.config.tablebase_path));
+    }
+
+  if (app->threats_width != 0)
+    {
+      return xo_exit (xo_tss_report (
+          app->threats_width, app->threats_height, app->threats_k,
+          app->threats_position, app->game->cpu.config.time_limit_ms,
+          app->game->cpu.config.node_limit));
+    }
+
   // SDL2 init
   if (SDL_Init (init_flags) < 0)
     {
@@ -1572,9 +10421,10 @@ main (int argc, char *argv[])
       return xo_exit (1);
     }
 
+  SDL_Point window_size = xo_util_window_size (&app->game->geometry);
   app->window
       = SDL_CreateWindow ("XO", SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
-                          XO_WINDOW_SIZE, XO_WINDOW_SIZE, window_flags);
+                          window_size.x, window_size.y, window_flags);
 
   if (app->window == NULL)
     {
@@ -1644,12 +10494,11 @@ main (int argc, char *argv[])
                                     square.y)
                       == SDL_TRUE)
                     {
-                      SDL_Point cpu_play = xo_game_cpu_find_next_play (app);
-                      if (xo_board_test_if_final_state (app->game->board->data)
-                          != XO_WIN_STATE_NONE)
+                      if (xo_game_final_state (app) != XO_WIN_STATE_NONE)
                         {
                           xo_exit (0);
                         }
+                      SDL_Point cpu_play = xo_game_cpu_find_next_play (app);
                       xo_game_play (app, XO_BIT_MEANING_SIDE_O, cpu_play.x,
                                     cpu_play.y);
                     }
@@ -1680,3 +10529,4 @@ main (int argc, char *argv[])
   xo_exit (0);
   return 0;
 }
+#endif